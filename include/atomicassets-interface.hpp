@@ -10,6 +10,7 @@ and custom data types.
 #include <eosio/eosio.hpp>
 #include <eosio/singleton.hpp>
 #include <eosio/asset.hpp>
+#include <eosio/crypto.hpp>
 
 using namespace eosio;
 using namespace std;
@@ -19,6 +20,14 @@ namespace atomicassets {
 
     static constexpr name ATOMICASSETS_ACCOUNT = name("atomicassets");
 
+    //Bits of assetsv2_s::flags and globalassets_s::flags
+    static constexpr uint8_t ASSET_FLAG_TRANSFERABLE   = 1;
+    static constexpr uint8_t ASSET_FLAG_BURNABLE       = 2;
+    static constexpr uint8_t ASSETV2_HAS_FLAGS         = 4;
+    static constexpr uint8_t ASSETV2_HAS_SCHEMA        = 8;
+    static constexpr uint8_t ASSETV2_HAS_BACKED_TOKENS = 16;
+    static constexpr uint8_t ASSETV2_HAS_BLOB          = 32;
+
     //Custom vector types need to be defined because otherwise a bug in the ABI serialization
     //would cause the ABI to be invalid
     typedef std::vector <int8_t>      INT8_VEC;
@@ -57,6 +66,8 @@ namespace atomicassets {
         vector <name>    notify_accounts;
         double           market_fee;
         vector <uint8_t> serialized_data;
+        //Event bitmask of each notify account, in the same order as notify_accounts. If not set, all events
+        binary_extension <vector <uint8_t>> notify_events;
 
         uint64_t primary_key() const { return collection_name.value; };
     };
@@ -64,10 +75,37 @@ namespace atomicassets {
     typedef multi_index <name("collections"), collections_s> collections_t;
 
 
+    //Scope: collection_name
+    //Only filled for collections that were created or had their authorized accounts changed after it was added
+    struct colauths_s {
+        name account;
+
+        uint64_t primary_key() const { return account.value; };
+    };
+
+    typedef multi_index <name("colauths"), colauths_s> colauths_t;
+
+
+    //Scope: collection_name
+    //Immutable data that is shared by assets and templates with byte-identical data
+    struct blobs_s {
+        uint64_t         blob_id;
+        checksum256      data_hash;
+        uint64_t         references;
+        vector <uint8_t> data;
+
+        uint64_t primary_key() const { return blob_id; };
+    };
+
+    typedef multi_index <name("blobs"), blobs_s> blobs_t;
+
+
     //Scope: collection_name
     struct schemas_s {
-        name            schema_name;
-        vector <FORMAT> format;
+        name                                  schema_name;
+        vector <FORMAT>                       format;
+        binary_extension <vector <uint64_t>> name_hashes;
+        binary_extension <vector <uint8_t>>  type_codes;
 
         uint64_t primary_key() const { return schema_name.value; }
     };
@@ -82,8 +120,10 @@ namespace atomicassets {
         bool             transferable;
         bool             burnable;
         uint32_t         max_supply;
-        uint32_t         issued_supply;
+        uint32_t         issued_supply; //Only up to date for templates without a row in the supplies table
         vector <uint8_t> immutable_serialized_data;
+        //If set, immutable_serialized_data is empty and the data is in the blobs table, see get_immutable_data()
+        binary_extension <uint64_t> immutable_blob_id;
 
         uint64_t primary_key() const { return (uint64_t) template_id; }
     };
@@ -91,6 +131,21 @@ namespace atomicassets {
     typedef multi_index <name("templates"), templates_s> templates_t;
 
 
+    //Scope: collection_name
+    //Use get_template_supply() to read the supply of any template, including those without a row
+    struct supplies_s {
+        int32_t  template_id;
+        uint32_t issued_supply;
+        uint32_t burned_supply;   //Only counts the burns since the row was created
+        uint32_t reserved_supply; //Assets that open airdrops still have to mint
+        bool     locked;          //Only open airdrops can still mint assets of the template, see locktemplate
+
+        uint64_t primary_key() const { return (uint64_t) template_id; }
+    };
+
+    typedef multi_index <name("supplies"), supplies_s> supplies_t;
+
+
     //Scope: owner
     struct assets_s {
         uint64_t         asset_id;
@@ -101,6 +156,11 @@ namespace atomicassets {
         vector <asset>   backed_tokens;
         vector <uint8_t> immutable_serialized_data;
         vector <uint8_t> mutable_serialized_data;
+        //Only set for assets minted while the asset flags feature was enabled, or with immutable_blob_id
+        //1 = transferable, 2 = burnable. If not set, the template's flags apply
+        binary_extension <uint8_t> flags;
+        //If set, immutable_serialized_data is empty and the data is in the blobs table, see get_immutable_data()
+        binary_extension <uint64_t> immutable_blob_id;
 
         uint64_t primary_key() const { return asset_id; };
     };
@@ -108,6 +168,105 @@ namespace atomicassets {
     typedef multi_index <name("assets"), assets_s> assets_t;
 
 
+    uint64_t read_varint(vector <uint8_t>::const_iterator &itr) {
+        uint64_t number = 0;
+        uint64_t shift = 0;
+        while (*itr >= 128) {
+            number |= ((uint64_t) (*itr - 128)) << shift;
+            itr++;
+            shift += 7;
+        }
+        number |= ((uint64_t) *itr) << shift;
+        itr++;
+        return number;
+    }
+
+    uint64_t read_uint64(vector <uint8_t>::const_iterator &itr) {
+        uint64_t number = 0;
+        for (int i = 0; i < 8; i++) {
+            number |= ((uint64_t) *itr) << (8 * i);
+            itr++;
+        }
+        return number;
+    }
+
+    //Reads the zigzag encoded template_id at the start of the data of assetsv2 and globalassets rows
+    int32_t read_template_id(const vector <uint8_t> &data) {
+        auto data_itr = data.begin();
+        uint64_t zigzag_template_id = read_varint(data_itr);
+        return (zigzag_template_id % 2 == 0)
+               ? (int32_t) (zigzag_template_id / 2)
+               : (int32_t) (zigzag_template_id / 2) * -1 - 1;
+    }
+
+
+    //Scope: owner
+    //Compact layout of assets_s, an asset is either in this table or in the assets table
+    //Use find_asset() to read an asset from either table, or unpack_asset() to convert a row of this table
+    struct assetsv2_s {
+        uint64_t         asset_id;
+        name             collection_name;
+        name             ram_payer;
+        uint8_t          flags;
+        vector <uint8_t> data;
+
+        uint64_t primary_key() const { return asset_id; };
+
+        int32_t get_template_id() const {
+            return read_template_id(data);
+        };
+
+        //Assets without a template (template_id -1) are sorted last within their collection
+        //The collection is the high half of the key, so lower_bound(collection << 64) lists the assets of a collection
+        uint128_t by_template() const {
+            return ((uint128_t) collection_name.value << 64) | (uint32_t) get_template_id();
+        };
+    };
+
+    //Only the assetsv2 table is indexed, assets in the assets table have to be iterated
+    typedef multi_index <name("assetsv2"), assetsv2_s,
+        indexed_by <name("template"), const_mem_fun <assetsv2_s, uint128_t, &assetsv2_s::by_template>>>
+    assetsv2_t;
+
+
+    //Key of the owner index of the globalassets table
+    //Assets without a template (template_id -1) are sorted last within their collection
+    checksum256 get_global_owner_key(name owner, name collection_name, int32_t template_id) {
+        return checksum256(std::array <uint128_t, 2>{
+            ((uint128_t) owner.value << 64) | collection_name.value,
+            (uint128_t) (uint32_t) template_id
+        });
+    }
+
+
+    //Scope: self
+    //Same layout as assetsv2_s, but in a single table for all owners
+    //Only used while FEATURE_GLOBAL_ASSETS is enabled, assets of an owner can be in any of the three asset tables
+    struct globalassets_s {
+        uint64_t         asset_id;
+        name             owner;
+        name             collection_name;
+        name             ram_payer;
+        uint8_t          flags;
+        vector <uint8_t> data;
+
+        uint64_t primary_key() const { return asset_id; };
+
+        int32_t get_template_id() const {
+            return read_template_id(data);
+        };
+
+        //Sorted by owner, then collection, then template (see get_global_owner_key)
+        checksum256 by_owner() const {
+            return get_global_owner_key(owner, collection_name, get_template_id());
+        };
+    };
+
+    typedef multi_index <name("globalassets"), globalassets_s,
+        indexed_by <name("owner"), const_mem_fun <globalassets_s, checksum256, &globalassets_s::by_owner>>>
+    globalassets_t;
+
+
     struct offers_s {
         uint64_t          offer_id;
         name              sender;
@@ -116,19 +275,66 @@ namespace atomicassets {
         vector <uint64_t> recipient_asset_ids;
         string            memo;
         name              ram_payer;
+        binary_extension <time_point_sec> expires_at; //Only set for offers created with an expiry
 
         uint64_t primary_key() const { return offer_id; };
 
         uint64_t by_sender() const { return sender.value; };
 
         uint64_t by_recipient() const { return recipient.value; };
+
+        //Offers without an expiry are sorted last
+        uint64_t by_expiry() const {
+            return expires_at.has_value() ? expires_at.value().sec_since_epoch() : ULLONG_MAX;
+        };
     };
 
+    //Offers created before the expiry index existed are not part of it, which is fine because they never expire
     typedef multi_index <name("offers"), offers_s,
         indexed_by < name("sender"), const_mem_fun < offers_s, uint64_t, &offers_s::by_sender>>,
-    indexed_by <name("recipient"), const_mem_fun < offers_s, uint64_t, &offers_s::by_recipient>>>
+    indexed_by <name("recipient"), const_mem_fun < offers_s, uint64_t, &offers_s::by_recipient>>,
+    indexed_by <name("expiry"), const_mem_fun < offers_s, uint64_t, &offers_s::by_expiry>>>
     offers_t;
 
+    struct airdrops_s {
+        uint64_t airdrop_id;
+        name     collection_name;
+        name     schema_name;
+        int32_t  template_id;
+        name     authorized_minter;
+        uint64_t assets_minted;
+        uint64_t assets_remaining;
+
+        uint64_t primary_key() const { return airdrop_id; };
+    };
+
+    typedef multi_index <name("airdrops"), airdrops_s> airdrops_t;
+
+
+    //Scope: asset_id
+    //Offers created before this table existed are not listed
+    //Listed offers are not erased when the asset moves, so they have to be checked for the current owners
+    struct assetoffers_s {
+        uint64_t offer_id;
+
+        uint64_t primary_key() const { return offer_id; };
+    };
+
+    typedef multi_index <name("assetoffers"), assetoffers_s> assetoffers_t;
+
+
+    //Scope: airdrop_id
+    struct dropchunks_s {
+        uint64_t         chunk_id;
+        vector <name>    recipients;
+        vector <uint8_t> ram_reserve;
+
+        uint64_t primary_key() const { return chunk_id; };
+    };
+
+    typedef multi_index <name("dropchunks"), dropchunks_s> dropchunks_t;
+
+
     struct balances_s {
         name           owner;
         vector <asset> quantities;
@@ -138,33 +344,70 @@ namespace atomicassets {
 
     typedef multi_index <name("balances"), balances_s>       balances_t;
 
+    //Scope: owner
+    //Balances are moved from the balances table to this table the next time that their owner changes them
+    struct symbalances_s {
+        asset quantity;
+
+        uint64_t primary_key() const { return quantity.symbol.code().raw(); };
+    };
+
+    typedef multi_index <name("symbalances"), symbalances_s> symbalances_t;
+
+
+    //Same tokens as config_s::supported_tokens, keyed by symbol code
+    struct suptokens_s {
+        extended_symbol token;
+
+        uint64_t primary_key() const { return token.get_symbol().code().raw(); };
+    };
+
+    typedef multi_index <name("suptokens"), suptokens_s>     suptokens_t;
 
+    //The counters in here are outdated once the counters table exists, read them from there instead
     struct config_s {
         uint64_t                 asset_counter     = 1099511627776; //2^40
         int32_t                  template_counter  = 1;
         uint64_t                 offer_counter     = 1;
         vector <FORMAT>          collection_format = {};
         vector <extended_symbol> supported_tokens  = {};
+        binary_extension <vector <uint64_t>> collection_format_hashes;
+        binary_extension <vector <uint8_t>>  collection_format_types;
     };
     typedef singleton <name("config"), config_s>             config_t;
 
+    struct counters_s {
+        uint64_t asset_counter    = 1099511627776; //2^40
+        int32_t  template_counter = 1;
+        uint64_t offer_counter    = 1;
+    };
+    typedef singleton <name("counters"), counters_s>         counters_t;
+
     struct tokenconfigs_s {
         name        standard = name("atomicassets");
-        std::string version  = string("1.2.3");
+        std::string version  = string("1.4.0"); //Since 1.4.0, template supplies are in the supplies table
     };
     typedef singleton <name("tokenconfigs"), tokenconfigs_s> tokenconfigs_t;
 
 
     collections_t  collections  = collections_t(ATOMICASSETS_ACCOUNT, ATOMICASSETS_ACCOUNT.value);
     offers_t       offers       = offers_t(ATOMICASSETS_ACCOUNT, ATOMICASSETS_ACCOUNT.value);
+    airdrops_t     airdrops     = airdrops_t(ATOMICASSETS_ACCOUNT, ATOMICASSETS_ACCOUNT.value);
     balances_t     balances     = balances_t(ATOMICASSETS_ACCOUNT, ATOMICASSETS_ACCOUNT.value);
+    suptokens_t    suptokens    = suptokens_t(ATOMICASSETS_ACCOUNT, ATOMICASSETS_ACCOUNT.value);
     config_t       config       = config_t(ATOMICASSETS_ACCOUNT, ATOMICASSETS_ACCOUNT.value);
+    counters_t     counters     = counters_t(ATOMICASSETS_ACCOUNT, ATOMICASSETS_ACCOUNT.value);
     tokenconfigs_t tokenconfigs = tokenconfigs_t(ATOMICASSETS_ACCOUNT, ATOMICASSETS_ACCOUNT.value);
+    globalassets_t globalassets = globalassets_t(ATOMICASSETS_ACCOUNT, ATOMICASSETS_ACCOUNT.value);
 
     assets_t get_assets(name acc) {
         return assets_t(ATOMICASSETS_ACCOUNT, acc.value);
     }
 
+    assetsv2_t get_assetsv2(name acc) {
+        return assetsv2_t(ATOMICASSETS_ACCOUNT, acc.value);
+    }
+
     schemas_t get_schemas(name collection_name) {
         return schemas_t(ATOMICASSETS_ACCOUNT, collection_name.value);
     }
@@ -172,4 +415,150 @@ namespace atomicassets {
     templates_t get_templates(name collection_name) {
         return templates_t(ATOMICASSETS_ACCOUNT, collection_name.value);
     }
+
+    supplies_t get_supplies(name collection_name) {
+        return supplies_t(ATOMICASSETS_ACCOUNT, collection_name.value);
+    }
+
+    //Returns the supply counters of a template, which are in the template row itself for older templates
+    supplies_s get_template_supply(name collection_name, const templates_s &template_row) {
+        supplies_t collection_supplies = get_supplies(collection_name);
+        auto supply_itr = collection_supplies.find(template_row.template_id);
+        if (supply_itr != collection_supplies.end()) {
+            return *supply_itr;
+        }
+        return supplies_s{template_row.template_id, template_row.issued_supply, 0, 0, false};
+    }
+
+    symbalances_t get_symbol_balances(name owner) {
+        return symbalances_t(ATOMICASSETS_ACCOUNT, owner.value);
+    }
+
+    assetoffers_t get_asset_offers(uint64_t asset_id) {
+        return assetoffers_t(ATOMICASSETS_ACCOUNT, asset_id);
+    }
+
+    dropchunks_t get_airdrop_chunks(uint64_t airdrop_id) {
+        return dropchunks_t(ATOMICASSETS_ACCOUNT, airdrop_id);
+    }
+
+    blobs_t get_blobs(name collection_name) {
+        return blobs_t(ATOMICASSETS_ACCOUNT, collection_name.value);
+    }
+
+    //Returns the immutable serialized data of an asset, no matter if it is stored inline or as a blob
+    vector <uint8_t> get_immutable_data(const assets_s &asset) {
+        if (asset.immutable_blob_id.has_value()) {
+            return get_blobs(asset.collection_name).get(asset.immutable_blob_id.value()).data;
+        }
+        return asset.immutable_serialized_data;
+    }
+
+    //Converts a row of the assetsv2 table into the assets_s layout
+    assets_s unpack_asset(const assetsv2_s &asset_row) {
+        assets_s unpacked = {};
+        unpacked.asset_id = asset_row.asset_id;
+        unpacked.collection_name = asset_row.collection_name;
+        unpacked.ram_payer = asset_row.ram_payer;
+
+        auto data_itr = asset_row.data.cbegin();
+        read_varint(data_itr);
+        unpacked.template_id = asset_row.get_template_id();
+
+        if (asset_row.flags & ASSETV2_HAS_SCHEMA) {
+            unpacked.schema_name = name(read_uint64(data_itr));
+        } else {
+            unpacked.schema_name = get_templates(asset_row.collection_name).get(unpacked.template_id).schema_name;
+        }
+
+        if (asset_row.flags & ASSETV2_HAS_BACKED_TOKENS) {
+            uint64_t token_count = read_varint(data_itr);
+            for (uint64_t i = 0; i < token_count; i++) {
+                int64_t amount = (int64_t) read_varint(data_itr);
+                unpacked.backed_tokens.push_back(asset(amount, symbol(read_uint64(data_itr))));
+            }
+        }
+
+        if (asset_row.flags & ASSETV2_HAS_FLAGS) {
+            unpacked.flags.emplace(asset_row.flags & (ASSET_FLAG_TRANSFERABLE | ASSET_FLAG_BURNABLE));
+        }
+        if (asset_row.flags & ASSETV2_HAS_BLOB) {
+            unpacked.immutable_blob_id.emplace(read_uint64(data_itr));
+        }
+
+        uint64_t immutable_length = read_varint(data_itr);
+        unpacked.immutable_serialized_data.assign(data_itr, data_itr + immutable_length);
+        data_itr += immutable_length;
+        unpacked.mutable_serialized_data.assign(data_itr, asset_row.data.cend());
+
+        return unpacked;
+    }
+
+    //Looks up an asset of owner in the globalassets, the assetsv2 and the assets table
+    //Returns false if owner doesn't own an asset with this id
+    bool find_asset(name owner, uint64_t asset_id, assets_s &asset_row) {
+        auto global_itr = globalassets.find(asset_id);
+        if (global_itr != globalassets.end()) {
+            if (global_itr->owner != owner) {
+                return false;
+            }
+            asset_row = unpack_asset(assetsv2_s{
+                global_itr->asset_id,
+                global_itr->collection_name,
+                global_itr->ram_payer,
+                global_itr->flags,
+                global_itr->data
+            });
+            return true;
+        }
+
+        assetsv2_t owner_assetsv2 = get_assetsv2(owner);
+        auto assetv2_itr = owner_assetsv2.find(asset_id);
+        if (assetv2_itr != owner_assetsv2.end()) {
+            asset_row = unpack_asset(*assetv2_itr);
+            return true;
+        }
+
+        assets_t owner_assets = get_assets(owner);
+        auto asset_itr = owner_assets.find(asset_id);
+        if (asset_itr == owner_assets.end()) {
+            return false;
+        }
+        asset_row = *asset_itr;
+        return true;
+    }
+
+    //Checks if owner owns at least one asset of the template
+    //This is an index lookup for assets in the assetsv2 and globalassets tables, but iterates over the assets table
+    bool owns_template(name owner, name collection_name, int32_t template_id) {
+        auto owner_assetsv2 = get_assetsv2(owner).get_index <name("template")>();
+        uint128_t template_key = ((uint128_t) collection_name.value << 64) | (uint32_t) template_id;
+        auto assetv2_itr = owner_assetsv2.lower_bound(template_key);
+        if (assetv2_itr != owner_assetsv2.end() && assetv2_itr->by_template() == template_key) {
+            return true;
+        }
+
+        auto owner_global_assets = globalassets.get_index <name("owner")>();
+        checksum256 owner_key = get_global_owner_key(owner, collection_name, template_id);
+        auto global_itr = owner_global_assets.lower_bound(owner_key);
+        if (global_itr != owner_global_assets.end() && global_itr->by_owner() == owner_key) {
+            return true;
+        }
+
+        assets_t owner_assets = get_assets(owner);
+        for (const assets_s &asset_row : owner_assets) {
+            if (asset_row.collection_name == collection_name && asset_row.template_id == template_id) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    //Returns the immutable serialized data of a template, no matter if it is stored inline or as a blob
+    vector <uint8_t> get_immutable_data(name collection_name, const templates_s &template_row) {
+        if (template_row.immutable_blob_id.has_value()) {
+            return get_blobs(collection_name).get(template_row.immutable_blob_id.value()).data;
+        }
+        return template_row.immutable_serialized_data;
+    }
 };
\ No newline at end of file
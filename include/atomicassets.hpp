@@ -1,6 +1,7 @@
 #include <eosio/eosio.hpp>
 #include <eosio/singleton.hpp>
 #include <eosio/asset.hpp>
+#include <eosio/crypto.hpp>
 
 #include <checkformat.hpp>
 #include <atomicdata.hpp>
@@ -12,6 +13,98 @@ using namespace atomicdata;
 
 static constexpr double MAX_MARKET_FEE = 0.15;
 
+//Maximum amount of recipients stored in a single airdrop chunk row
+static constexpr uint64_t AIRDROP_CHUNK_SIZE = 50;
+
+//Upper bounds for the RAM that is billed for a table row (in addition to its data) and for each table of a new scope
+//A new scope creates one table for the rows and one for each secondary index
+static constexpr uint64_t RAM_ROW_OVERHEAD   = 112;
+static constexpr uint64_t RAM_SCOPE_OVERHEAD = 112;
+//Number of secondary indices of the tables that assets can be stored in
+static constexpr uint64_t ASSETS_INDEX_COUNT       = 0;
+static constexpr uint64_t ASSETSV2_INDEX_COUNT     = 1;
+static constexpr uint64_t GLOBALASSETS_INDEX_COUNT = 1;
+//RAM that is billed for each secondary index entry of a row, including its key, depending on the key type
+static constexpr uint64_t RAM_INDEX128_OVERHEAD = 136;
+static constexpr uint64_t RAM_INDEX256_OVERHEAD = 152;
+
+//Features that can be enabled contract wide with the setfeatures action
+static constexpr uint64_t FEATURE_ASSET_FLAGS           = 1; //Minted assets store their template's transferable and burnable flags
+static constexpr uint64_t FEATURE_COMBINED_TRANSFER_LOG = 2; //Transfers log all collections with a single logtransfer2
+static constexpr uint64_t FEATURE_RAW_DATA_LOGS         = 4; //Mints, burns and data changes log the serialized data
+static constexpr uint64_t FEATURE_SHARED_BLOBS          = 8; //New assets and templates store their immutable data in the blobs table
+static constexpr uint64_t FEATURE_COMPACT_ASSETS        = 16; //Minted and moved assets are stored in the assetsv2 table
+static constexpr uint64_t FEATURE_GLOBAL_ASSETS         = 32; //Minted and moved assets are stored in the globalassets table
+
+//Bits of assetsv2_s::flags, in addition to the ASSET_FLAG_* bits
+static constexpr uint8_t ASSETV2_HAS_FLAGS         = 4;  //The ASSET_FLAG_* bits are set. Otherwise the template's flags apply
+static constexpr uint8_t ASSETV2_HAS_SCHEMA        = 8;  //The asset has no template, so its schema_name is stored
+static constexpr uint8_t ASSETV2_HAS_BACKED_TOKENS = 16;
+static constexpr uint8_t ASSETV2_HAS_BLOB          = 32; //The immutable data is in the blobs table
+
+//Immutable data shorter than this is always stored inline, because a blobs row costs more RAM than it could save
+static constexpr uint64_t MIN_SHARED_BLOB_SIZE = 64;
+
+//Events that a collection's notify accounts can be notified about (see setnotifyflt)
+static constexpr uint8_t NOTIFY_TRANSFER = 1;  //logtransfer, logtransfers, logtransfer2
+static constexpr uint8_t NOTIFY_TEMPLATE = 2;  //lognewtempl
+static constexpr uint8_t NOTIFY_MINT     = 4;  //logmint, logmintraw
+static constexpr uint8_t NOTIFY_SETDATA  = 8;  //logsetdata, logsetraw
+static constexpr uint8_t NOTIFY_BACK     = 16; //logbackasset, logbackbatch
+static constexpr uint8_t NOTIFY_BURN     = 32; //logburnasset, logburnraw, logburnbatch
+static constexpr uint8_t NOTIFY_ALL      = 0xFF;
+
+//Bits of the flags byte stored in asset rows
+static constexpr uint8_t ASSET_FLAG_TRANSFERABLE = 1;
+static constexpr uint8_t ASSET_FLAG_BURNABLE     = 2;
+
+
+//The data of a single asset minted with the mintassets action
+struct MINT_DATA {
+    name           new_asset_owner;
+    ATTRIBUTE_MAP  immutable_data;
+    ATTRIBUTE_MAP  mutable_data;
+    vector <asset> tokens_to_back;
+};
+
+//A group of assets sent to one recipient with the transfermulti action
+struct TRANSFER_GROUP {
+    name              to;
+    vector <uint64_t> asset_ids;
+    string            memo;
+};
+
+//The assets of one collection within a transfer, as logged by logtransfer2
+struct COLLECTION_ASSETS {
+    name              collection_name;
+    vector <uint64_t> asset_ids;
+};
+
+//A token to back an asset with, used by the backassets action
+struct ASSET_BACKING {
+    uint64_t asset_id;
+    asset    token_to_back;
+};
+
+//The tokens that were added to an asset with the backassets action, as logged by logbackbatch
+struct BACKED_ASSET {
+    uint64_t       asset_id;
+    name           collection_name;
+    vector <asset> added_tokens;
+};
+
+//An asset burned with the burnassets action, as logged by logburnbatch
+struct BURNED_ASSET {
+    uint64_t         asset_id;
+    name             collection_name;
+    name             schema_name;
+    int32_t          template_id;
+    vector <asset>   backed_tokens;
+    vector <uint8_t> immutable_serialized_data;
+    vector <uint8_t> mutable_serialized_data;
+    name             asset_ram_payer;
+};
+
 
 CONTRACT atomicassets : public contract {
 public:
@@ -25,6 +118,8 @@ public:
 
     ACTION addconftoken(name token_contract, symbol token_symbol);
 
+    ACTION setfeatures(uint64_t enabled_features);
+
 
     ACTION transfer(
         name from,
@@ -33,6 +128,11 @@ public:
         string memo
     );
 
+    ACTION transfermulti(
+        name from,
+        vector <TRANSFER_GROUP> transfers
+    );
+
 
     ACTION createcol(
         name author,
@@ -78,6 +178,12 @@ public:
         name collection_name
     );
 
+    ACTION setnotifyflt(
+        name collection_name,
+        name notify_account,
+        uint8_t events
+    );
+
 
     ACTION createschema(
         name authorized_creator,
@@ -122,6 +228,14 @@ public:
         vector <asset> tokens_to_back
     );
 
+    ACTION mintassets(
+        name authorized_minter,
+        name collection_name,
+        name schema_name,
+        int32_t template_id,
+        vector <MINT_DATA> assets_to_mint
+    );
+
     ACTION setassetdata(
         name authorized_editor,
         name asset_owner,
@@ -130,6 +244,34 @@ public:
     );
 
 
+    ACTION createdrop(
+        name authorized_minter,
+        name collection_name,
+        name schema_name,
+        int32_t template_id,
+        vector <name> recipients
+    );
+
+    ACTION extenddrop(
+        uint64_t airdrop_id,
+        vector <name> recipients
+    );
+
+    ACTION crank(
+        uint64_t airdrop_id,
+        uint32_t max_assets
+    );
+
+    ACTION canceldrop(
+        uint64_t airdrop_id
+    );
+
+    ACTION topupdrop(
+        uint64_t airdrop_id,
+        uint32_t max_chunks
+    );
+
+
     ACTION announcedepo(
         name owner,
         symbol symbol_to_announce
@@ -140,6 +282,10 @@ public:
         asset token_to_withdraw
     );
 
+    ACTION withdrawall(
+        name owner
+    );
+
     ACTION backasset(
         name payer,
         name asset_owner,
@@ -147,18 +293,36 @@ public:
         asset token_to_back
     );
 
+    ACTION backassets(
+        name payer,
+        name asset_owner,
+        vector <ASSET_BACKING> backings
+    );
+
     ACTION burnasset(
         name asset_owner,
         uint64_t asset_id
     );
 
+    ACTION burnassets(
+        name asset_owner,
+        vector <uint64_t> asset_ids
+    );
+
+    ACTION migassets(
+        name owner,
+        uint64_t lower_bound_id,
+        uint32_t max_assets
+    );
+
 
     ACTION createoffer(
         name sender,
         name recipient,
         vector <uint64_t> sender_asset_ids,
         vector <uint64_t> recipient_asset_ids,
-        string memo
+        string memo,
+        binary_extension <time_point_sec> expires_at
     );
 
     ACTION canceloffer(
@@ -173,6 +337,11 @@ public:
         uint64_t offer_id
     );
 
+    ACTION gcoffers(
+        uint32_t max_offers,
+        binary_extension <vector <uint64_t>> offer_ids
+    );
+
     ACTION payofferram(
         name payer,
         uint64_t offer_id
@@ -193,13 +362,27 @@ public:
         string memo
     );
 
+    ACTION logtransfers(
+        name collection_name,
+        name from,
+        vector <TRANSFER_GROUP> transfers
+    );
+
+    ACTION logtransfer2(
+        name from,
+        name to,
+        vector <COLLECTION_ASSETS> collection_assets,
+        string memo
+    );
+
     ACTION lognewoffer(
         uint64_t offer_id,
         name sender,
         name recipient,
         vector <uint64_t> sender_asset_ids,
         vector <uint64_t> recipient_asset_ids,
-        string memo
+        string memo,
+        binary_extension <time_point_sec> expires_at
     );
 
     ACTION lognewtempl(
@@ -226,6 +409,18 @@ public:
         ATTRIBUTE_MAP immutable_template_data
     );
 
+    ACTION logmintraw(
+        uint64_t asset_id,
+        name authorized_minter,
+        name collection_name,
+        name schema_name,
+        int32_t template_id,
+        name new_asset_owner,
+        vector <uint8_t> immutable_serialized_data,
+        vector <uint8_t> mutable_serialized_data,
+        vector <asset> backed_tokens
+    );
+
     ACTION logsetdata(
         name asset_owner,
         uint64_t asset_id,
@@ -233,6 +428,15 @@ public:
         ATTRIBUTE_MAP new_data
     );
 
+    ACTION logsetraw(
+        name asset_owner,
+        uint64_t asset_id,
+        name collection_name,
+        name schema_name,
+        vector <uint8_t> old_serialized_data,
+        vector <uint8_t> new_serialized_data
+    );
+
     ACTION logbackasset(
         name asset_owner,
         uint64_t asset_id,
@@ -251,6 +455,34 @@ public:
         name asset_ram_payer
     );
 
+    ACTION logburnraw(
+        name asset_owner,
+        uint64_t asset_id,
+        name collection_name,
+        name schema_name,
+        int32_t template_id,
+        vector <asset> backed_tokens,
+        vector <uint8_t> old_immutable_serialized_data,
+        vector <uint8_t> old_mutable_serialized_data,
+        name asset_ram_payer
+    );
+
+    ACTION logburnbatch(
+        name asset_owner,
+        vector <BURNED_ASSET> burned_assets
+    );
+
+    ACTION logbackbatch(
+        name payer,
+        name asset_owner,
+        vector <BACKED_ASSET> backed_assets
+    );
+
+    ACTION logskiptoken(
+        extended_symbol skipped_token,
+        extended_symbol supported_token
+    );
+
 
 private:
 
@@ -262,6 +494,9 @@ private:
         vector <name>    notify_accounts;
         double           market_fee;
         vector <uint8_t> serialized_data;
+        //NOTIFY_* events of each notify account, in the same order as notify_accounts
+        //If not set, all notify accounts are notified about all events
+        binary_extension <vector <uint8_t>> notify_events;
 
         uint64_t primary_key() const { return collection_name.value; };
     };
@@ -269,10 +504,39 @@ private:
     typedef multi_index <name("collections"), collections_s> collections_t;
 
 
+    //Scope: collection_name
+    //Copy of the authorized_accounts of a collection, so that authorizations can be checked with a single lookup
+    //Collections created before this table existed are copied by their next addcolauth or remcolauth
+    TABLE colauths_s {
+        name account;
+
+        uint64_t primary_key() const { return account.value; };
+    };
+
+    typedef multi_index <name("colauths"), colauths_s> colauths_t;
+
+
+    //Scope: collection_name
+    //Immutable data that is shared by all assets and templates of the collection with byte-identical data
+    //The row is erased when the last asset referencing it is burned. Templates are never erased, so they keep their blob
+    TABLE blobs_s {
+        uint64_t         blob_id;    //The first 8 bytes of data_hash
+        checksum256      data_hash;  //sha256 of data
+        uint64_t         references;
+        vector <uint8_t> data;
+
+        uint64_t primary_key() const { return blob_id; };
+    };
+
+    typedef multi_index <name("blobs"), blobs_s> blobs_t;
+
+
     //Scope: collection_name
     TABLE schemas_s {
-        name            schema_name;
-        vector <FORMAT> format;
+        name                                  schema_name;
+        vector <FORMAT>                       format;
+        binary_extension <vector <uint64_t>> name_hashes; //Sorted, see get_name_hashes()
+        binary_extension <vector <uint8_t>>  type_codes;  //One compiled type code per format line
 
         uint64_t primary_key() const { return schema_name.value; }
     };
@@ -287,8 +551,9 @@ private:
         bool             transferable;
         bool             burnable;
         uint32_t         max_supply;
-        uint32_t         issued_supply;
+        uint32_t         issued_supply; //Only up to date for templates without a row in the supplies table
         vector <uint8_t> immutable_serialized_data;
+        binary_extension <uint64_t> immutable_blob_id; //If set, the immutable data is in the blobs table instead
 
         uint64_t primary_key() const { return (uint64_t) template_id; }
     };
@@ -296,6 +561,22 @@ private:
     typedef multi_index <name("templates"), templates_s> templates_t;
 
 
+    //Scope: collection_name
+    //Supply counters of a template, kept apart so that minting doesn't rewrite the template row
+    //Templates created before this table existed get their row once they are minted or airdropped again
+    TABLE supplies_s {
+        int32_t  template_id;
+        uint32_t issued_supply;
+        uint32_t burned_supply;   //Only counts the burns since the row was created
+        uint32_t reserved_supply; //Assets that open airdrops still have to mint
+        bool     locked;          //Only open airdrops can still mint assets of the template, see locktemplate
+
+        uint64_t primary_key() const { return (uint64_t) template_id; }
+    };
+
+    typedef multi_index <name("supplies"), supplies_s> supplies_t;
+
+
     //Scope: owner
     TABLE assets_s {
         uint64_t         asset_id;
@@ -306,6 +587,8 @@ private:
         vector <asset>   backed_tokens;
         vector <uint8_t> immutable_serialized_data;
         vector <uint8_t> mutable_serialized_data;
+        binary_extension <uint8_t> flags; //ASSET_FLAG_* bits, set if FEATURE_ASSET_FLAGS was enabled at mint or if immutable_blob_id is set
+        binary_extension <uint64_t> immutable_blob_id; //If set, the immutable data is in the blobs table instead
 
         uint64_t primary_key() const { return asset_id; };
     };
@@ -313,6 +596,81 @@ private:
     typedef multi_index <name("assets"), assets_s> assets_t;
 
 
+    //Scope: owner
+    //Compact layout of assets_s. Only names that can't be derived from the template are stored,
+    //and everything else is packed into data (see pack_asset):
+    //  varint zigzag template_id
+    //  schema_name                                      if ASSETV2_HAS_SCHEMA
+    //  varint count, (varint amount, symbol) per token  if ASSETV2_HAS_BACKED_TOKENS
+    //  immutable_blob_id                                if ASSETV2_HAS_BLOB
+    //  varint length, immutable_serialized_data
+    //  mutable_serialized_data (until the end of data)
+    TABLE assetsv2_s {
+        uint64_t         asset_id;
+        name             collection_name;
+        name             ram_payer;
+        uint8_t          flags; //ASSET_FLAG_* and ASSETV2_* bits
+        vector <uint8_t> data;
+
+        uint64_t primary_key() const { return asset_id; };
+
+        int32_t get_template_id() const {
+            auto data_itr = data.begin();
+            return (int32_t) zigzagDecode(unsignedFromVarintBytes(data_itr));
+        };
+
+        //Assets without a template (template_id -1) are sorted last within their collection
+        //The collection is the high half of the key, so this also lists the assets of a collection
+        uint128_t by_template() const {
+            return ((uint128_t) collection_name.value << 64) | (uint32_t) get_template_id();
+        };
+    };
+
+    //The legacy assets table has no secondary indices, because adding them would make every move of a legacy
+    //asset increase the RAM of its ram_payer, who usually doesn't authorize transfers
+    typedef multi_index <name("assetsv2"), assetsv2_s,
+        indexed_by <name("template"), const_mem_fun <assetsv2_s, uint128_t, &assetsv2_s::by_template>>>
+    assetsv2_t;
+
+
+    //Key of the owner index of the globalassets table
+    //Assets without a template (template_id -1) are sorted last within their collection
+    static checksum256 get_global_owner_key(name owner, name collection_name, int32_t template_id) {
+        return checksum256(std::array <uint128_t, 2>{
+            ((uint128_t) owner.value << 64) | collection_name.value,
+            (uint128_t) (uint32_t) template_id
+        });
+    }
+
+    //Assets of all owners in a single table, so that moving an asset only changes the owner of its row
+    //The other fields are the same as in assetsv2_s
+    TABLE globalassets_s {
+        uint64_t         asset_id;
+        name             owner;
+        name             collection_name;
+        name             ram_payer;
+        uint8_t          flags; //ASSET_FLAG_* and ASSETV2_* bits
+        vector <uint8_t> data;
+
+        uint64_t primary_key() const { return asset_id; };
+
+        int32_t get_template_id() const {
+            auto data_itr = data.begin();
+            return (int32_t) zigzagDecode(unsignedFromVarintBytes(data_itr));
+        };
+
+        //Sorted by owner, then collection, then template (see get_global_owner_key)
+        checksum256 by_owner() const {
+            return get_global_owner_key(owner, collection_name, get_template_id());
+        };
+    };
+
+    //A single 256 bit index covers lookups by owner, by owner and collection, and by owner and template
+    typedef multi_index <name("globalassets"), globalassets_s,
+        indexed_by <name("owner"), const_mem_fun <globalassets_s, checksum256, &globalassets_s::by_owner>>>
+    globalassets_t;
+
+
     TABLE offers_s {
         uint64_t          offer_id;
         name              sender;
@@ -321,19 +679,75 @@ private:
         vector <uint64_t> recipient_asset_ids;
         string            memo;
         name              ram_payer;
+        binary_extension <time_point_sec> expires_at; //Only set for offers created with an expiry
 
         uint64_t primary_key() const { return offer_id; };
 
         uint64_t by_sender() const { return sender.value; };
 
         uint64_t by_recipient() const { return recipient.value; };
+
+        //Offers without an expiry are sorted last
+        uint64_t by_expiry() const {
+            return expires_at.has_value() ? expires_at.value().sec_since_epoch() : ULLONG_MAX;
+        };
     };
 
+    //Offers created before the expiry index existed are not part of it, which is fine because they never expire
     typedef multi_index <name("offers"), offers_s,
         indexed_by < name("sender"), const_mem_fun < offers_s, uint64_t, &offers_s::by_sender>>,
-    indexed_by <name("recipient"), const_mem_fun < offers_s, uint64_t, &offers_s::by_recipient>>>
+    indexed_by <name("recipient"), const_mem_fun < offers_s, uint64_t, &offers_s::by_recipient>>,
+    indexed_by <name("expiry"), const_mem_fun < offers_s, uint64_t, &offers_s::by_expiry>>>
     offers_t;
 
+    TABLE airdrops_s {
+        uint64_t airdrop_id;
+        name     collection_name;
+        name     schema_name;
+        int32_t  template_id;
+        name     authorized_minter;
+        uint64_t assets_minted;
+        uint64_t assets_remaining;
+
+        uint64_t primary_key() const { return airdrop_id; };
+    };
+
+    typedef multi_index <name("airdrops"), airdrops_s> airdrops_t;
+
+
+    //Scope: asset_id
+    //Lists the offers that an asset is part of, paid for by the ram_payer of the offer
+    //Entries are only removed together with their offer, so offers listed here can be dead because the asset moved.
+    //Such offers are not erased when the asset moves, because anyone can create any number of offers for an asset,
+    //which would make moving it too expensive. Instead, they can be erased by anyone with gcoffers.
+    //Offers created before this table existed are not listed
+    TABLE assetoffers_s {
+        uint64_t offer_id;
+
+        uint64_t primary_key() const { return offer_id; };
+    };
+
+    typedef multi_index <name("assetoffers"), assetoffers_s> assetoffers_t;
+
+
+    //Scope: airdrop_id
+    //ram_reserve is RAM paid for by the authorized_minter of the airdrop upfront. It shrinks by the RAM of every
+    //asset minted to the chunk's recipients, so that crank can bill the assets to the minter without their auth.
+    //Its bytes are never read, only its size matters: RAM is billed by the size of the stored rows, so holding RAM
+    //for an account means storing that many bytes in a row it pays for. Because RAM_RESTRICTIONS only lets an
+    //action increase the RAM of the accounts that authorized it, crank keeps the minter's net RAM usage from
+    //increasing by shrinking the reserve by at least as much as the assets it bills to the minter.
+    TABLE dropchunks_s {
+        uint64_t         chunk_id;
+        vector <name>    recipients;
+        vector <uint8_t> ram_reserve;
+
+        uint64_t primary_key() const { return chunk_id; };
+    };
+
+    typedef multi_index <name("dropchunks"), dropchunks_s> dropchunks_t;
+
+
     TABLE balances_s {
         name           owner;
         vector <asset> quantities;
@@ -343,21 +757,64 @@ private:
 
     typedef multi_index <name("balances"), balances_s>         balances_t;
 
+    //Scope: owner
+    //Replaces the quantities vector of balances_s with one row per symbol. A balances row is moved into this table
+    //by the next balance change that its owner authorizes
+    TABLE symbalances_s {
+        asset quantity;
 
+        uint64_t primary_key() const { return quantity.symbol.code().raw(); };
+    };
+
+    typedef multi_index <name("symbalances"), symbalances_s>   symbalances_t;
+
+
+    //Indexed copy of config_s::supported_tokens, so that token transfers don't have to read the config
+    //Symbol codes are unique among the supported tokens
+    TABLE suptokens_s {
+        extended_symbol token;
+
+        uint64_t primary_key() const { return token.get_symbol().code().raw(); };
+    };
+
+    typedef multi_index <name("suptokens"), suptokens_s>       suptokens_t;
+
+
+    //The counters are only kept for the row layout and for moving them to the counters table, see get_counters()
     TABLE config_s {
         uint64_t                 asset_counter     = 1099511627776; //2^40
         int32_t                  template_counter  = 1;
         uint64_t                 offer_counter     = 1;
         vector <FORMAT>          collection_format = {};
         vector <extended_symbol> supported_tokens  = {};
+        binary_extension <vector <uint64_t>> collection_format_hashes; //Sorted, see get_name_hashes()
+        binary_extension <vector <uint8_t>>  collection_format_types;  //One compiled type code per format line
     };
     typedef singleton <name("config"), config_s>               config_t;
     // https://github.com/EOSIO/eosio.cdt/issues/280
     typedef multi_index <name("config"), config_s>             config_t_for_abi;
 
+    //Kept separate from the config, so that actions that only need a new id don't read and write the config vectors
+    TABLE counters_s {
+        uint64_t asset_counter    = 1099511627776; //2^40
+        int32_t  template_counter = 1;
+        uint64_t offer_counter    = 1;
+    };
+    typedef singleton <name("counters"), counters_s>           counters_t;
+    // https://github.com/EOSIO/eosio.cdt/issues/280
+    typedef multi_index <name("counters"), counters_s>         counters_t_for_abi;
+
+    TABLE features_s {
+        uint64_t enabled_features = 0; //FEATURE_* bits
+        uint64_t used_features    = 0; //FEATURE_* bits that have been enabled at any time
+    };
+    typedef singleton <name("features"), features_s>           features_t;
+    // https://github.com/EOSIO/eosio.cdt/issues/280
+    typedef multi_index <name("features"), features_s>         features_t_for_abi;
+
     TABLE tokenconfigs_s {
         name        standard = name("atomicassets");
-        std::string version  = string("1.3.1");
+        std::string version  = string("1.4.0"); //Since 1.4.0, template supplies are in the supplies table
     };
     typedef singleton <name("tokenconfigs"), tokenconfigs_s>   tokenconfigs_t;
     // https://github.com/EOSIO/eosio.cdt/issues/280
@@ -366,11 +823,31 @@ private:
 
     collections_t  collections  = collections_t(get_self(), get_self().value);
     offers_t       offers       = offers_t(get_self(), get_self().value);
+    globalassets_t globalassets = globalassets_t(get_self(), get_self().value);
+    airdrops_t     airdrops     = airdrops_t(get_self(), get_self().value);
     balances_t     balances     = balances_t(get_self(), get_self().value);
+    suptokens_t    suptokens    = suptokens_t(get_self(), get_self().value);
     config_t       config       = config_t(get_self(), get_self().value);
+    counters_t     counters     = counters_t(get_self(), get_self().value);
+    features_t     features     = features_t(get_self(), get_self().value);
     tokenconfigs_t tokenconfigs = tokenconfigs_t(get_self(), get_self().value);
 
 
+    struct template_flags {
+        bool transferable;
+        bool burnable;
+    };
+
+    //These caches only live for a single action, because the contract is instantiated for every action
+    map <name, templates_t>                     templates_cache      = {};
+    map <pair <name, int32_t>, template_flags> template_flags_cache = {};
+    map <name, blobs_t>                         blobs_cache          = {};
+    map <name, assets_t>                        assets_cache         = {};
+    map <name, assetsv2_t>                      assetsv2_cache       = {};
+    features_s                                  features_cache       = {};
+    bool                                        features_cached      = false;
+
+
     void internal_transfer(
         name from,
         name to,
@@ -379,6 +856,56 @@ private:
         name scope_payer
     );
 
+    void internal_send_assets(
+        name from,
+        name to,
+        const vector <uint64_t> &asset_ids,
+        const string &memo,
+        name scope_payer,
+        const char *from_description,
+        bool check_transferable
+    );
+
+    void internal_index_offer(const offers_s &offer);
+
+    void internal_erase_offer(const offers_s &offer);
+
+    map <name, vector <uint64_t>> internal_move_assets(
+        name from,
+        name to,
+        const vector <uint64_t> &asset_ids,
+        name scope_payer,
+        const char *from_description,
+        bool check_transferable
+    );
+
+    void internal_mint_assets(
+        name authorized_minter,
+        name collection_name,
+        name schema_name,
+        int32_t template_id,
+        const vector <MINT_DATA> &assets_to_mint,
+        bool from_reserved_supply
+    );
+
+    void internal_add_airdrop_recipients(
+        uint64_t airdrop_id,
+        name authorized_minter,
+        const vector <name> &recipients
+    );
+
+    uint64_t get_airdrop_asset_ram(bool compact_assets, bool global_assets);
+
+    uint64_t get_airdrop_recipient_ram();
+
+    uint64_t get_asset_scope_ram(bool compact_assets, bool global_assets);
+
+    uint64_t get_asset_row_ram(const assets_s &asset_row);
+
+    uint64_t get_asset_row_ram(const assetsv2_s &asset_row);
+
+    uint64_t get_asset_row_ram(const globalassets_s &asset_row);
+
     void internal_back_asset(
         name ram_payer,
         name asset_owner,
@@ -386,13 +913,73 @@ private:
         asset back_quantity
     );
 
+    void internal_migrate_balance(name owner);
+
+    void internal_decrease_legacy_balance(
+        name owner,
+        asset quantity
+    );
+
+    void internal_increase_legacy_balance(
+        name owner,
+        asset quantity
+    );
+
+    extended_symbol get_supported_token(symbol token_symbol);
+
     void internal_decrease_balance(
         name owner,
         asset quantity
     );
 
+    void internal_increase_balance(
+        name owner,
+        const vector <asset> &quantities
+    );
+
     void notify_collection_accounts(
-        name collection_name
+        name collection_name,
+        uint8_t event
+    );
+
+    void internal_copy_collection_auths(const collections_s &collection);
+
+    bool internal_store_blob(
+        name collection_name,
+        const vector <uint8_t> &data,
+        name ram_payer,
+        uint64_t &blob_id
+    );
+
+    void internal_release_blob(
+        name collection_name,
+        uint64_t blob_id
+    );
+
+    void internal_init_template_supply(
+        name collection_name,
+        const templates_s &template_row,
+        name ram_payer
+    );
+
+    void internal_issue_template_supply(
+        name collection_name,
+        const templates_s &template_row,
+        uint64_t amount,
+        name ram_payer,
+        bool from_reserved_supply
+    );
+
+    void internal_reserve_template_supply(
+        name collection_name,
+        const templates_s &template_row,
+        int64_t amount
+    );
+
+    void internal_burn_template_supply(
+        name collection_name,
+        int32_t template_id,
+        uint32_t amount
     );
 
     void check_has_collection_auth(
@@ -403,9 +990,84 @@ private:
 
     void check_name_length(ATTRIBUTE_MAP data);
 
+    counters_s get_counters();
+
+    vector <uint8_t> get_schema_type_codes(const schemas_s &schema);
+
+    vector <uint8_t> get_collection_format_types(const config_s &current_config);
+
     assets_t get_assets(name acc);
 
+    assetsv2_t get_assetsv2(name acc);
+
     schemas_t get_schemas(name collection_name);
 
     templates_t get_templates(name collection_name);
+
+    supplies_t get_supplies(name collection_name);
+
+    supplies_s get_template_supply(name collection_name, const templates_s &template_row);
+
+    templates_t &get_cached_templates(name collection_name);
+
+    const template_flags &get_template_flags(name collection_name, int32_t template_id);
+
+    blobs_t &get_cached_blobs(name collection_name);
+
+    vector <uint8_t> get_immutable_data(const assets_s &asset);
+
+    vector <uint8_t> get_immutable_data(name collection_name, const templates_s &template_row);
+
+    template_flags get_asset_flags(const assets_s &asset);
+
+    template_flags get_asset_flags(const assetsv2_s &asset);
+
+    template_flags get_asset_flags(const globalassets_s &asset);
+
+    bool use_compact_assets();
+
+    bool use_global_assets();
+
+    bool global_assets_used();
+
+    assets_t &get_cached_assets(name owner);
+
+    assetsv2_t &get_cached_assetsv2(name owner);
+
+    assetsv2_s pack_asset(const assets_s &asset_row);
+
+    assets_s unpack_asset(const assetsv2_s &asset_row);
+
+    globalassets_s pack_global_asset(name owner, const assets_s &asset_row);
+
+    assets_s unpack_asset(const globalassets_s &asset_row);
+
+    name get_asset_schema(const assets_s &asset);
+
+    bool find_asset(name owner, uint64_t asset_id, assets_s &asset);
+
+    bool owns_asset(name owner, uint64_t asset_id);
+
+    bool is_offer_acceptable(const offers_s &offer);
+
+    bool asset_scope_exists(name owner);
+
+    void internal_store_asset(name owner, const assets_s &asset);
+
+    void internal_update_asset(name owner, const assets_s &asset);
+
+    void internal_erase_asset(name owner, uint64_t asset_id);
+
+    const features_s &get_features();
+
+    bool is_feature_enabled(uint64_t feature);
+
+    dropchunks_t get_airdrop_chunks(uint64_t airdrop_id);
+
+    assetoffers_t get_asset_offers(uint64_t asset_id);
+
+    colauths_t get_collection_auths(name collection_name);
+
+
+    symbalances_t get_symbol_balances(name owner);
 };
@@ -39,6 +39,93 @@ namespace atomicdata {
 
     static constexpr uint64_t RESERVED = 4;
 
+    //Compiled type codes, one for each type string that is valid in a FORMAT line
+    //Vector types (e.g. uint64[]) have the TYPE_ARRAY_FLAG bit set in addition to the code of their base type
+    static constexpr uint8_t TYPE_INT8       = 1;
+    static constexpr uint8_t TYPE_INT16      = 2;
+    static constexpr uint8_t TYPE_INT32      = 3;
+    static constexpr uint8_t TYPE_INT64      = 4;
+    static constexpr uint8_t TYPE_UINT8      = 5;
+    static constexpr uint8_t TYPE_UINT16     = 6;
+    static constexpr uint8_t TYPE_UINT32     = 7;
+    static constexpr uint8_t TYPE_UINT64     = 8;
+    static constexpr uint8_t TYPE_FIXED8     = 9;
+    static constexpr uint8_t TYPE_FIXED16    = 10;
+    static constexpr uint8_t TYPE_FIXED32    = 11;
+    static constexpr uint8_t TYPE_FIXED64    = 12;
+    static constexpr uint8_t TYPE_FLOAT      = 13;
+    static constexpr uint8_t TYPE_DOUBLE     = 14;
+    static constexpr uint8_t TYPE_STRING     = 15;
+    static constexpr uint8_t TYPE_IMAGE      = 16;
+    static constexpr uint8_t TYPE_IPFS       = 17;
+    static constexpr uint8_t TYPE_BOOL       = 18;
+    static constexpr uint8_t TYPE_BYTES      = 19;
+    static constexpr uint8_t TYPE_ARRAY_FLAG = 0x80;
+
+    struct TYPE_DEFINITION {
+        const char *type;
+        size_t     length;
+        uint8_t    code;
+    };
+
+    //Every valid (non vector) type that can be used in a FORMAT line
+    static constexpr TYPE_DEFINITION TYPE_DEFINITIONS[] = {
+        {"int8",    4, TYPE_INT8},
+        {"int16",   5, TYPE_INT16},
+        {"int32",   5, TYPE_INT32},
+        {"int64",   5, TYPE_INT64},
+        {"uint8",   5, TYPE_UINT8},
+        {"uint16",  6, TYPE_UINT16},
+        {"uint32",  6, TYPE_UINT32},
+        {"uint64",  6, TYPE_UINT64},
+        {"fixed8",  6, TYPE_FIXED8},
+        {"fixed16", 7, TYPE_FIXED16},
+        {"fixed32", 7, TYPE_FIXED32},
+        {"fixed64", 7, TYPE_FIXED64},
+        {"float",   5, TYPE_FLOAT},
+        {"double",  6, TYPE_DOUBLE},
+        {"string",  6, TYPE_STRING},
+        {"image",   5, TYPE_IMAGE},
+        {"ipfs",    4, TYPE_IPFS},
+        {"bool",    4, TYPE_BOOL},
+        {"bytes",   5, TYPE_BYTES}
+    };
+
+
+    /*
+    Compiles a type string into its type code
+    Returns 0 if the type is not valid
+    */
+    uint8_t compile_type(const string &type) {
+        size_t base_length = type.length();
+        uint8_t array_flag = 0;
+        if (base_length > 2 && type[base_length - 2] == '[' && type[base_length - 1] == ']') {
+            base_length -= 2;
+            array_flag = TYPE_ARRAY_FLAG;
+        }
+
+        for (const TYPE_DEFINITION &definition : TYPE_DEFINITIONS) {
+            if (definition.length == base_length && type.compare(0, base_length, definition.type) == 0) {
+                return definition.code | array_flag;
+            }
+        }
+        return 0;
+    }
+
+
+    /*
+    Returns the compiled type code of each line of a format
+    Used for rows that were written before the type codes were stored alongside the format
+    */
+    vector <uint8_t> get_type_codes(const vector <FORMAT> &lines) {
+        vector <uint8_t> type_codes = {};
+        type_codes.reserve(lines.size());
+        for (const FORMAT &line : lines) {
+            type_codes.push_back(compile_type(line.type));
+        }
+        return type_codes;
+    }
+
 
     vector <uint8_t> toVarintBytes(uint64_t number, uint64_t original_bytes = 8) {
         if (original_bytes < 8) {
@@ -113,387 +200,300 @@ namespace atomicdata {
     }
 
 
-    vector <uint8_t> serialize_attribute(const string &type, const ATOMIC_ATTRIBUTE &attr) {
-        if (type.find("[]", type.length() - 2) == type.length() - 2) {
-            //Type is an array
-            string base_type = type.substr(0, type.length() - 2);
+    template <typename VEC>
+    vector <uint8_t> serialize_vector(uint8_t base_type, const VEC &vec);
 
-            if (std::holds_alternative <INT8_VEC>(attr)) {
-                INT8_VEC vec = std::get <INT8_VEC>(attr);
-                vector <uint8_t> serialized_data = toVarintBytes(vec.size());
-                for (auto child : vec) {
-                    ATOMIC_ATTRIBUTE child_attr = child;
-                    vector <uint8_t> serialized_element = serialize_attribute(base_type, child_attr);
-                    serialized_data.insert(serialized_data.end(), serialized_element.begin(), serialized_element.end());
-                }
-                return serialized_data;
 
-            } else if (std::holds_alternative <INT16_VEC>(attr)) {
-                INT16_VEC vec = std::get <INT16_VEC>(attr);
-                vector <uint8_t> serialized_data = toVarintBytes(vec.size());
-                for (auto child : vec) {
-                    ATOMIC_ATTRIBUTE child_attr = child;
-                    vector <uint8_t> serialized_element = serialize_attribute(base_type, child_attr);
-                    serialized_data.insert(serialized_data.end(), serialized_element.begin(), serialized_element.end());
-                }
-                return serialized_data;
+    /*
+    Serializes an attribute of the type with the compiled type code (see TYPE_INT8 etc.)
+    */
+    vector <uint8_t> serialize_attribute(uint8_t type, const ATOMIC_ATTRIBUTE &attr) {
+        if (type & TYPE_ARRAY_FLAG) {
+            uint8_t base_type = type & ~TYPE_ARRAY_FLAG;
 
+            if (std::holds_alternative <INT8_VEC>(attr)) {
+                return serialize_vector(base_type, std::get <INT8_VEC>(attr));
+            } else if (std::holds_alternative <INT16_VEC>(attr)) {
+                return serialize_vector(base_type, std::get <INT16_VEC>(attr));
             } else if (std::holds_alternative <INT32_VEC>(attr)) {
-                INT32_VEC vec = std::get <INT32_VEC>(attr);
-                vector <uint8_t> serialized_data = toVarintBytes(vec.size());
-                for (auto child : vec) {
-                    ATOMIC_ATTRIBUTE child_attr = child;
-                    vector <uint8_t> serialized_element = serialize_attribute(base_type, child_attr);
-                    serialized_data.insert(serialized_data.end(), serialized_element.begin(), serialized_element.end());
-                }
-                return serialized_data;
-
+                return serialize_vector(base_type, std::get <INT32_VEC>(attr));
             } else if (std::holds_alternative <INT64_VEC>(attr)) {
-                INT64_VEC vec = std::get <INT64_VEC>(attr);
-                vector <uint8_t> serialized_data = toVarintBytes(vec.size());
-                for (auto child : vec) {
-                    ATOMIC_ATTRIBUTE child_attr = child;
-                    vector <uint8_t> serialized_element = serialize_attribute(base_type, child_attr);
-                    serialized_data.insert(serialized_data.end(), serialized_element.begin(), serialized_element.end());
-                }
-                return serialized_data;
-
+                return serialize_vector(base_type, std::get <INT64_VEC>(attr));
             } else if (std::holds_alternative <UINT8_VEC>(attr)) {
-                UINT8_VEC vec = std::get <UINT8_VEC>(attr);
-                vector <uint8_t> serialized_data = toVarintBytes(vec.size());
-                for (auto child : vec) {
-                    ATOMIC_ATTRIBUTE child_attr = child;
-                    vector <uint8_t> serialized_element = serialize_attribute(base_type, child_attr);
-                    serialized_data.insert(serialized_data.end(), serialized_element.begin(), serialized_element.end());
-                }
-                return serialized_data;
-
+                return serialize_vector(base_type, std::get <UINT8_VEC>(attr));
             } else if (std::holds_alternative <UINT16_VEC>(attr)) {
-                UINT16_VEC vec = std::get <UINT16_VEC>(attr);
-                vector <uint8_t> serialized_data = toVarintBytes(vec.size());
-                for (auto child : vec) {
-                    ATOMIC_ATTRIBUTE child_attr = child;
-                    vector <uint8_t> serialized_element = serialize_attribute(base_type, child_attr);
-                    serialized_data.insert(serialized_data.end(), serialized_element.begin(), serialized_element.end());
-                }
-                return serialized_data;
-
+                return serialize_vector(base_type, std::get <UINT16_VEC>(attr));
             } else if (std::holds_alternative <UINT32_VEC>(attr)) {
-                UINT32_VEC vec = std::get <UINT32_VEC>(attr);
-                vector <uint8_t> serialized_data = toVarintBytes(vec.size());
-                for (auto child : vec) {
-                    ATOMIC_ATTRIBUTE child_attr = child;
-                    vector <uint8_t> serialized_element = serialize_attribute(base_type, child_attr);
-                    serialized_data.insert(serialized_data.end(), serialized_element.begin(), serialized_element.end());
-                }
-                return serialized_data;
-
+                return serialize_vector(base_type, std::get <UINT32_VEC>(attr));
             } else if (std::holds_alternative <UINT64_VEC>(attr)) {
-                UINT64_VEC vec = std::get <UINT64_VEC>(attr);
-                vector <uint8_t> serialized_data = toVarintBytes(vec.size());
-                for (auto child : vec) {
-                    ATOMIC_ATTRIBUTE child_attr = child;
-                    vector <uint8_t> serialized_element = serialize_attribute(base_type, child_attr);
-                    serialized_data.insert(serialized_data.end(), serialized_element.begin(), serialized_element.end());
-                }
-                return serialized_data;
-
+                return serialize_vector(base_type, std::get <UINT64_VEC>(attr));
             } else if (std::holds_alternative <FLOAT_VEC>(attr)) {
-                FLOAT_VEC vec = std::get <FLOAT_VEC>(attr);
-                vector <uint8_t> serialized_data = toVarintBytes(vec.size());
-                for (auto child : vec) {
-                    ATOMIC_ATTRIBUTE child_attr = child;
-                    vector <uint8_t> serialized_element = serialize_attribute(base_type, child_attr);
-                    serialized_data.insert(serialized_data.end(), serialized_element.begin(), serialized_element.end());
-                }
-                return serialized_data;
-
+                return serialize_vector(base_type, std::get <FLOAT_VEC>(attr));
             } else if (std::holds_alternative <DOUBLE_VEC>(attr)) {
-                DOUBLE_VEC vec = std::get <DOUBLE_VEC>(attr);
-                vector <uint8_t> serialized_data = toVarintBytes(vec.size());
-                for (auto child : vec) {
-                    ATOMIC_ATTRIBUTE child_attr = child;
-                    vector <uint8_t> serialized_element = serialize_attribute(base_type, child_attr);
-                    serialized_data.insert(serialized_data.end(), serialized_element.begin(), serialized_element.end());
-                }
-                return serialized_data;
-
+                return serialize_vector(base_type, std::get <DOUBLE_VEC>(attr));
             } else if (std::holds_alternative <STRING_VEC>(attr)) {
-                STRING_VEC vec = std::get <STRING_VEC>(attr);
-                vector <uint8_t> serialized_data = toVarintBytes(vec.size());
-                for (auto child : vec) {
-                    ATOMIC_ATTRIBUTE child_attr = child;
-                    vector <uint8_t> serialized_element = serialize_attribute(base_type, child_attr);
-                    serialized_data.insert(serialized_data.end(), serialized_element.begin(), serialized_element.end());
-                }
-                return serialized_data;
-
+                return serialize_vector(base_type, std::get <STRING_VEC>(attr));
             }
         }
 
-        if (type == "int8") {
-            check(std::holds_alternative <int8_t>(attr), "Expected a int8, but got something else");
-            return toVarintBytes(zigzagEncode(std::get <int8_t>(attr)), 1);
-        } else if (type == "int16") {
-            check(std::holds_alternative <int16_t>(attr), "Expected a int16, but got something else");
-            return toVarintBytes(zigzagEncode(std::get <int16_t>(attr)), 2);
-        } else if (type == "int32") {
-            check(std::holds_alternative <int32_t>(attr), "Expected a int32, but got something else");
-            return toVarintBytes(zigzagEncode(std::get <int32_t>(attr)), 4);
-        } else if (type == "int64") {
-            check(std::holds_alternative <int64_t>(attr), "Expected a int64, but got something else");
-            return toVarintBytes(zigzagEncode(std::get <int64_t>(attr)), 8);
-
-        } else if (type == "uint8") {
-            check(std::holds_alternative <uint8_t>(attr), "Expected a uint8, but got something else");
-            return toVarintBytes(std::get <uint8_t>(attr), 1);
-        } else if (type == "uint16") {
-            check(std::holds_alternative <uint16_t>(attr), "Expected a uint16, but got something else");
-            return toVarintBytes(std::get <uint16_t>(attr), 2);
-        } else if (type == "uint32") {
-            check(std::holds_alternative <uint32_t>(attr), "Expected a uint32, but got something else");
-            return toVarintBytes(std::get <uint32_t>(attr), 4);
-        } else if (type == "uint64") {
-            check(std::holds_alternative <uint64_t>(attr), "Expected a uint64, but got something else");
-            return toVarintBytes(std::get <uint64_t>(attr), 8);
-
-        } else if (type == "fixed8" || type == "byte") {
-            check(std::holds_alternative <uint8_t>(attr), "Expected a uint8 (fixed8 / byte), but got something else");
-            return toIntBytes(std::get <uint8_t>(attr), 1);
-        } else if (type == "fixed16") {
-            check(std::holds_alternative <uint16_t>(attr), "Expected a uint16 (fixed16), but got something else");
-            return toIntBytes(std::get <uint16_t>(attr), 2);
-        } else if (type == "fixed32") {
-            check(std::holds_alternative <uint32_t>(attr), "Expected a uint32 (fixed32), but got something else");
-            return toIntBytes(std::get <uint32_t>(attr), 4);
-        } else if (type == "fixed64") {
-            check(std::holds_alternative <uint64_t>(attr), "Expected a uint64 (fixed64), but got something else");
-            return toIntBytes(std::get <uint64_t>(attr), 8);
-
-        } else if (type == "float") {
-            check(std::holds_alternative <float>(attr), "Expected a float, but got something else");
-            float float_value = std::get <float>(attr);
-            auto *byte_value = reinterpret_cast<uint8_t *>(&float_value);
-            vector <uint8_t> serialized_data = {};
-            serialized_data.reserve(4);
-            for (int i = 0; i < 4; i++) {
-                serialized_data.push_back(*(byte_value + i));
+        switch (type) {
+            case TYPE_INT8:
+                check(std::holds_alternative <int8_t>(attr), "Expected a int8, but got something else");
+                return toVarintBytes(zigzagEncode(std::get <int8_t>(attr)), 1);
+            case TYPE_INT16:
+                check(std::holds_alternative <int16_t>(attr), "Expected a int16, but got something else");
+                return toVarintBytes(zigzagEncode(std::get <int16_t>(attr)), 2);
+            case TYPE_INT32:
+                check(std::holds_alternative <int32_t>(attr), "Expected a int32, but got something else");
+                return toVarintBytes(zigzagEncode(std::get <int32_t>(attr)), 4);
+            case TYPE_INT64:
+                check(std::holds_alternative <int64_t>(attr), "Expected a int64, but got something else");
+                return toVarintBytes(zigzagEncode(std::get <int64_t>(attr)), 8);
+
+            case TYPE_UINT8:
+                check(std::holds_alternative <uint8_t>(attr), "Expected a uint8, but got something else");
+                return toVarintBytes(std::get <uint8_t>(attr), 1);
+            case TYPE_UINT16:
+                check(std::holds_alternative <uint16_t>(attr), "Expected a uint16, but got something else");
+                return toVarintBytes(std::get <uint16_t>(attr), 2);
+            case TYPE_UINT32:
+                check(std::holds_alternative <uint32_t>(attr), "Expected a uint32, but got something else");
+                return toVarintBytes(std::get <uint32_t>(attr), 4);
+            case TYPE_UINT64:
+                check(std::holds_alternative <uint64_t>(attr), "Expected a uint64, but got something else");
+                return toVarintBytes(std::get <uint64_t>(attr), 8);
+
+            case TYPE_FIXED8:
+                check(std::holds_alternative <uint8_t>(attr), "Expected a uint8 (fixed8 / byte), but got something else");
+                return toIntBytes(std::get <uint8_t>(attr), 1);
+            case TYPE_FIXED16:
+                check(std::holds_alternative <uint16_t>(attr), "Expected a uint16 (fixed16), but got something else");
+                return toIntBytes(std::get <uint16_t>(attr), 2);
+            case TYPE_FIXED32:
+                check(std::holds_alternative <uint32_t>(attr), "Expected a uint32 (fixed32), but got something else");
+                return toIntBytes(std::get <uint32_t>(attr), 4);
+            case TYPE_FIXED64:
+                check(std::holds_alternative <uint64_t>(attr), "Expected a uint64 (fixed64), but got something else");
+                return toIntBytes(std::get <uint64_t>(attr), 8);
+
+            case TYPE_FLOAT: {
+                check(std::holds_alternative <float>(attr), "Expected a float, but got something else");
+                float float_value = std::get <float>(attr);
+                auto *byte_value = reinterpret_cast<uint8_t *>(&float_value);
+                return vector <uint8_t>(byte_value, byte_value + 4);
             }
-            return serialized_data;
-
-        } else if (type == "double") {
-            check(std::holds_alternative <double>(attr), "Expected a double, but got something else");
-            double float_value = std::get <double>(attr);
-            auto *byte_value = reinterpret_cast<uint8_t *>(&float_value);
-            vector <uint8_t> serialized_data = {};
-            serialized_data.reserve(8);
-            for (int i = 0; i < 8; i++) {
-                serialized_data.push_back(*(byte_value + i));
+            case TYPE_DOUBLE: {
+                check(std::holds_alternative <double>(attr), "Expected a double, but got something else");
+                double float_value = std::get <double>(attr);
+                auto *byte_value = reinterpret_cast<uint8_t *>(&float_value);
+                return vector <uint8_t>(byte_value, byte_value + 8);
             }
-            return serialized_data;
-
-        } else if (type == "string" || type == "image") {
-            check(std::holds_alternative <string>(attr), "Expected a string, but got something else");
-            string text = std::get <string>(attr);
-            vector <uint8_t> serialized_data(text.begin(), text.end());
-
-            vector <uint8_t> length_bytes = toVarintBytes(text.length());
-            serialized_data.insert(serialized_data.begin(), length_bytes.begin(), length_bytes.end());
-            return serialized_data;
-
-        } else if (type == "ipfs") {
-            check(std::holds_alternative <string>(attr), "Expected a string (ipfs), but got something else");
-            vector <uint8_t> result = {};
-            check(DecodeBase58(std::get <string>(attr), result),
-                "Error when decoding IPFS string");
-            vector <uint8_t> length_bytes = toVarintBytes(result.size());
-            result.insert(result.begin(), length_bytes.begin(), length_bytes.end());
-            return result;
-
-        } else if (type == "bool") {
-            check(std::holds_alternative <uint8_t>(attr),
-                "Expected a bool (needs to be provided as uint8_t because of C++ restrictions), but got something else");
-            uint8_t value = std::get <uint8_t>(attr);
-            check(value == 0 || value == 1,
-                "Bools need to be provided as an uin8_t that is either 0 or 1");
-            return {value};
 
-        } else {
-            check(false, "No type could be matched - " + type);
-            return {}; //This point can never be reached because the check above will always throw.
-            //Just to silence the compiler warning
-        }
-    }
+            case TYPE_STRING:
+            case TYPE_IMAGE: {
+                check(std::holds_alternative <string>(attr), "Expected a string, but got something else");
+                const string &text = std::get <string>(attr);
+                vector <uint8_t> serialized_data = toVarintBytes(text.length());
+                serialized_data.insert(serialized_data.end(), text.begin(), text.end());
+                return serialized_data;
+            }
 
+            case TYPE_IPFS: {
+                check(std::holds_alternative <string>(attr), "Expected a string (ipfs), but got something else");
+                vector <uint8_t> result = {};
+                check(DecodeBase58(std::get <string>(attr), result),
+                    "Error when decoding IPFS string");
+                vector <uint8_t> length_bytes = toVarintBytes(result.size());
+                result.insert(result.begin(), length_bytes.begin(), length_bytes.end());
+                return result;
+            }
 
-    ATOMIC_ATTRIBUTE deserialize_attribute(const string &type, vector <const uint8_t>::iterator &itr) {
-        if (type.find("[]", type.length() - 2) == type.length() - 2) {
-            //Type is an array
-            uint64_t array_length = unsignedFromVarintBytes(itr);
-            string base_type = type.substr(0, type.length() - 2);
+            case TYPE_BOOL: {
+                check(std::holds_alternative <uint8_t>(attr),
+                    "Expected a bool (needs to be provided as uint8_t because of C++ restrictions), but got something else");
+                uint8_t value = std::get <uint8_t>(attr);
+                check(value == 0 || value == 1,
+                    "Bools need to be provided as an uin8_t that is either 0 or 1");
+                return {value};
+            }
 
-            if (type == "int8[]") {
-                INT8_VEC vec = {};
-                for (uint64_t i = 0; i < array_length; i++) {
-                    vec.push_back(std::get <int8_t>(deserialize_attribute(base_type, itr)));
-                }
-                return vec;
-            } else if (type == "int16[]") {
-                INT16_VEC vec = {};
-                for (uint64_t i = 0; i < array_length; i++) {
-                    vec.push_back(std::get <int16_t>(deserialize_attribute(base_type, itr)));
-                }
-                return vec;
-            } else if (type == "int32[]") {
-                INT32_VEC vec = {};
-                for (uint64_t i = 0; i < array_length; i++) {
-                    vec.push_back(std::get <int32_t>(deserialize_attribute(base_type, itr)));
-                }
-                return vec;
-            } else if (type == "int64[]") {
-                INT64_VEC vec = {};
-                for (uint64_t i = 0; i < array_length; i++) {
-                    vec.push_back(std::get <int64_t>(deserialize_attribute(base_type, itr)));
-                }
-                return vec;
+            default:
+                check(false, "No type could be matched - type code " + to_string(type));
+                return {}; //This point can never be reached because the check above will always throw.
+                //Just to silence the compiler warning
+        }
+    }
 
-            } else if (type == "uint8[]" || type == "fixed8[]" || type == "bool[]") {
-                UINT8_VEC vec = {};
-                for (uint64_t i = 0; i < array_length; i++) {
-                    vec.push_back(std::get <uint8_t>(deserialize_attribute(base_type, itr)));
-                }
-                return vec;
-            } else if (type == "uint16[]" || type == "fixed16[]") {
-                UINT16_VEC vec = {};
-                for (uint64_t i = 0; i < array_length; i++) {
-                    vec.push_back(std::get <uint16_t>(deserialize_attribute(base_type, itr)));
-                }
-                return vec;
-            } else if (type == "uint32[]" || type == "fixed32[]") {
-                UINT32_VEC vec = {};
-                for (uint64_t i = 0; i < array_length; i++) {
-                    vec.push_back(std::get <uint32_t>(deserialize_attribute(base_type, itr)));
-                }
-                return vec;
-            } else if (type == "uint64[]" || type == "fixed64[]") {
-                UINT64_VEC vec = {};
-                for (uint64_t i = 0; i < array_length; i++) {
-                    vec.push_back(std::get <uint64_t>(deserialize_attribute(base_type, itr)));
-                }
-                return vec;
 
-            } else if (type == "float[]") {
-                FLOAT_VEC vec = {};
-                for (uint64_t i = 0; i < array_length; i++) {
-                    vec.push_back(std::get <float>(deserialize_attribute(base_type, itr)));
-                }
-                return vec;
+    template <typename VEC>
+    vector <uint8_t> serialize_vector(uint8_t base_type, const VEC &vec) {
+        vector <uint8_t> serialized_data = toVarintBytes(vec.size());
+        for (const auto &child : vec) {
+            ATOMIC_ATTRIBUTE child_attr = child;
+            vector <uint8_t> serialized_element = serialize_attribute(base_type, child_attr);
+            serialized_data.insert(serialized_data.end(), serialized_element.begin(), serialized_element.end());
+        }
+        return serialized_data;
+    }
 
-            } else if (type == "double[]") {
-                DOUBLE_VEC vec = {};
-                for (uint64_t i = 0; i < array_length; i++) {
-                    vec.push_back(std::get <double>(deserialize_attribute(base_type, itr)));
-                }
-                return vec;
 
-            } else if (type == "string[]" || type == "image[]") {
-                STRING_VEC vec = {};
-                for (uint64_t i = 0; i < array_length; i++) {
-                    vec.push_back(std::get <string>(deserialize_attribute(base_type, itr)));
-                }
-                return vec;
+    template <typename T, typename VEC>
+    VEC deserialize_vector(uint8_t base_type, uint64_t array_length, vector <const uint8_t>::iterator &itr);
+
 
+    /*
+    Deserializes an attribute of the type with the compiled type code (see TYPE_INT8 etc.)
+    */
+    ATOMIC_ATTRIBUTE deserialize_attribute(uint8_t type, vector <const uint8_t>::iterator &itr) {
+        if (type & TYPE_ARRAY_FLAG) {
+            uint64_t array_length = unsignedFromVarintBytes(itr);
+            uint8_t base_type = type & ~TYPE_ARRAY_FLAG;
+
+            switch (base_type) {
+                case TYPE_INT8:
+                    return deserialize_vector <int8_t, INT8_VEC>(base_type, array_length, itr);
+                case TYPE_INT16:
+                    return deserialize_vector <int16_t, INT16_VEC>(base_type, array_length, itr);
+                case TYPE_INT32:
+                    return deserialize_vector <int32_t, INT32_VEC>(base_type, array_length, itr);
+                case TYPE_INT64:
+                    return deserialize_vector <int64_t, INT64_VEC>(base_type, array_length, itr);
+
+                case TYPE_UINT8:
+                case TYPE_FIXED8:
+                case TYPE_BOOL:
+                    return deserialize_vector <uint8_t, UINT8_VEC>(base_type, array_length, itr);
+                case TYPE_UINT16:
+                case TYPE_FIXED16:
+                    return deserialize_vector <uint16_t, UINT16_VEC>(base_type, array_length, itr);
+                case TYPE_UINT32:
+                case TYPE_FIXED32:
+                    return deserialize_vector <uint32_t, UINT32_VEC>(base_type, array_length, itr);
+                case TYPE_UINT64:
+                case TYPE_FIXED64:
+                    return deserialize_vector <uint64_t, UINT64_VEC>(base_type, array_length, itr);
+
+                case TYPE_FLOAT:
+                    return deserialize_vector <float, FLOAT_VEC>(base_type, array_length, itr);
+                case TYPE_DOUBLE:
+                    return deserialize_vector <double, DOUBLE_VEC>(base_type, array_length, itr);
+
+                case TYPE_STRING:
+                case TYPE_IMAGE:
+                    return deserialize_vector <string, STRING_VEC>(base_type, array_length, itr);
             }
         }
 
-        if (type == "int8") {
-            return (int8_t) zigzagDecode(unsignedFromVarintBytes(itr));
-        } else if (type == "int16") {
-            return (int16_t) zigzagDecode(unsignedFromVarintBytes(itr));
-        } else if (type == "int32") {
-            return (int32_t) zigzagDecode(unsignedFromVarintBytes(itr));
-        } else if (type == "int64") {
-            return (int64_t) zigzagDecode(unsignedFromVarintBytes(itr));
-
-        } else if (type == "uint8") {
-            return (uint8_t) unsignedFromVarintBytes(itr);
-        } else if (type == "uint16") {
-            return (uint16_t) unsignedFromVarintBytes(itr);
-        } else if (type == "uint32") {
-            return (uint32_t) unsignedFromVarintBytes(itr);
-        } else if (type == "uint64") {
-            return (uint64_t) unsignedFromVarintBytes(itr);
-
-        } else if (type == "fixed8") {
-            return (uint8_t) unsignedFromIntBytes(itr, 1);
-        } else if (type == "fixed16") {
-            return (uint16_t) unsignedFromIntBytes(itr, 2);
-        } else if (type == "fixed32") {
-            return (uint32_t) unsignedFromIntBytes(itr, 4);
-        } else if (type == "fixed64") {
-            return (uint64_t) unsignedFromIntBytes(itr, 8);
-
-        } else if (type == "float") {
-            uint8_t array_repr[4];
-            for (uint8_t &i : array_repr) {
-                i = *itr;
-                itr++;
+        switch (type) {
+            case TYPE_INT8:
+                return (int8_t) zigzagDecode(unsignedFromVarintBytes(itr));
+            case TYPE_INT16:
+                return (int16_t) zigzagDecode(unsignedFromVarintBytes(itr));
+            case TYPE_INT32:
+                return (int32_t) zigzagDecode(unsignedFromVarintBytes(itr));
+            case TYPE_INT64:
+                return (int64_t) zigzagDecode(unsignedFromVarintBytes(itr));
+
+            case TYPE_UINT8:
+                return (uint8_t) unsignedFromVarintBytes(itr);
+            case TYPE_UINT16:
+                return (uint16_t) unsignedFromVarintBytes(itr);
+            case TYPE_UINT32:
+                return (uint32_t) unsignedFromVarintBytes(itr);
+            case TYPE_UINT64:
+                return (uint64_t) unsignedFromVarintBytes(itr);
+
+            case TYPE_FIXED8:
+                return (uint8_t) unsignedFromIntBytes(itr, 1);
+            case TYPE_FIXED16:
+                return (uint16_t) unsignedFromIntBytes(itr, 2);
+            case TYPE_FIXED32:
+                return (uint32_t) unsignedFromIntBytes(itr, 4);
+            case TYPE_FIXED64:
+                return (uint64_t) unsignedFromIntBytes(itr, 8);
+
+            case TYPE_FLOAT: {
+                uint8_t array_repr[4];
+                for (uint8_t &i : array_repr) {
+                    i = *itr;
+                    itr++;
+                }
+                auto *val = reinterpret_cast<float *>(&array_repr);
+                return *val;
+            }
+            case TYPE_DOUBLE: {
+                uint8_t array_repr[8];
+                for (uint8_t &i : array_repr) {
+                    i = *itr;
+                    itr++;
+                }
+                auto *val = reinterpret_cast<double *>(&array_repr);
+                return *val;
             }
-            auto *val = reinterpret_cast<float *>(&array_repr);
-            return *val;
 
-        } else if (type == "double") {
-            uint8_t array_repr[8];
-            for (uint8_t &i : array_repr) {
-                i = *itr;
-                itr++;
+            case TYPE_STRING:
+            case TYPE_IMAGE: {
+                uint64_t string_length = unsignedFromVarintBytes(itr);
+                string text(itr, itr + string_length);
+
+                itr += string_length;
+                return text;
             }
-            auto *val = reinterpret_cast<double *>(&array_repr);
-            return *val;
 
-        } else if (type == "string" || type == "image") {
-            uint64_t string_length = unsignedFromVarintBytes(itr);
-            string text(itr, itr + string_length);
+            case TYPE_IPFS: {
+                uint64_t array_length = unsignedFromVarintBytes(itr);
+                vector <uint8_t> byte_array(itr, itr + array_length);
 
-            itr += string_length;
-            return text;
+                itr += array_length;
+                return EncodeBase58(byte_array);
+            }
 
-        } else if (type == "ipfs") {
-            uint64_t array_length = unsignedFromVarintBytes(itr);
-            vector <uint8_t> byte_array = {};
-            byte_array.insert(byte_array.begin(), itr, itr + array_length);
+            case TYPE_BOOL: {
+                uint8_t next_byte = *itr;
+                itr++;
+                return next_byte;
+            }
 
-            itr += array_length;
-            return EncodeBase58(byte_array);
+            default:
+                check(false, "No type could be matched - type code " + to_string(type));
+                return ""; //This point can never be reached because the check above will always throw.
+                //Just to silence the compiler warning
+        }
+    }
 
-        } else if (type == "bool" || type == "byte") {
-            uint8_t next_byte = *itr;
-            itr++;
-            return next_byte;
 
-        } else {
-            check(false, "No type could be matched - " + type);
-            return ""; //This point can never be reached because the check above will always throw.
-            //Just to silence the compiler warning
+    template <typename T, typename VEC>
+    VEC deserialize_vector(uint8_t base_type, uint64_t array_length, vector <const uint8_t>::iterator &itr) {
+        VEC vec = {};
+        vec.reserve(array_length);
+        for (uint64_t i = 0; i < array_length; i++) {
+            vec.push_back(std::get <T>(deserialize_attribute(base_type, itr)));
         }
+        return vec;
     }
 
 
-    vector <uint8_t> serialize(ATTRIBUTE_MAP attr_map, const vector <FORMAT> &format_lines) {
-        uint64_t number = 0;
+    /*
+    Serializes the attributes using the compiled type codes of the format lines
+    type_codes needs to have exactly one entry for each format line, see get_type_codes()
+    */
+    vector <uint8_t> serialize(
+        ATTRIBUTE_MAP attr_map,
+        const vector <FORMAT> &format_lines,
+        const vector <uint8_t> &type_codes
+    ) {
         vector <uint8_t> serialized_data = {};
-        for (FORMAT line : format_lines) {
-            auto attribute_itr = attr_map.find(line.name);
+        for (uint64_t number = 0; number < format_lines.size() && attr_map.size() != 0; number++) {
+            auto attribute_itr = attr_map.find(format_lines[number].name);
             if (attribute_itr != attr_map.end()) {
                 const vector <uint8_t> &identifier = toVarintBytes(number + RESERVED);
                 serialized_data.insert(serialized_data.end(), identifier.begin(), identifier.end());
 
-                const vector <uint8_t> &child_data = serialize_attribute(line.type, attribute_itr->second);
+                const vector <uint8_t> &child_data = serialize_attribute(type_codes[number], attribute_itr->second);
                 serialized_data.insert(serialized_data.end(), child_data.begin(), child_data.end());
 
                 attr_map.erase(attribute_itr);
             }
-            number++;
         }
         if (attr_map.begin() != attr_map.end()) {
             check(false,
@@ -504,16 +504,50 @@ namespace atomicdata {
     }
 
 
-    ATTRIBUTE_MAP deserialize(const vector <uint8_t> &data, const vector <FORMAT> &format_lines) {
+    /*
+    Deserializes data that was serialized with the same format lines and type codes
+    */
+    ATTRIBUTE_MAP deserialize(
+        const vector <uint8_t> &data,
+        const vector <FORMAT> &format_lines,
+        const vector <uint8_t> &type_codes
+    ) {
         ATTRIBUTE_MAP attr_map = {};
 
         auto itr = data.begin();
         while (itr != data.end()) {
-            uint64_t identifier = unsignedFromVarintBytes(itr);
-            FORMAT format = format_lines.at(identifier - RESERVED);
-            attr_map[format.name] = deserialize_attribute(format.type, itr);
+            uint64_t index = unsignedFromVarintBytes(itr) - RESERVED;
+            attr_map[format_lines.at(index).name] = deserialize_attribute(type_codes.at(index), itr);
         }
 
         return attr_map;
     }
+
+
+    /*
+    The following functions take the types as strings, as they are used in FORMAT lines
+    The types are compiled once and the type code based functions above do the actual work
+    */
+    vector <uint8_t> serialize_attribute(const string &type, const ATOMIC_ATTRIBUTE &attr) {
+        uint8_t type_code = compile_type(type);
+        check(type_code != 0, "No type could be matched - " + type);
+        return serialize_attribute(type_code, attr);
+    }
+
+
+    ATOMIC_ATTRIBUTE deserialize_attribute(const string &type, vector <const uint8_t>::iterator &itr) {
+        uint8_t type_code = compile_type(type);
+        check(type_code != 0, "No type could be matched - " + type);
+        return deserialize_attribute(type_code, itr);
+    }
+
+
+    vector <uint8_t> serialize(ATTRIBUTE_MAP attr_map, const vector <FORMAT> &format_lines) {
+        return serialize(std::move(attr_map), format_lines, get_type_codes(format_lines));
+    }
+
+
+    ATTRIBUTE_MAP deserialize(const vector <uint8_t> &data, const vector <FORMAT> &format_lines) {
+        return deserialize(data, format_lines, get_type_codes(format_lines));
+    }
 }
\ No newline at end of file
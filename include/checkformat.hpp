@@ -1,5 +1,6 @@
 #include <eosio/eosio.hpp>
 #include <algorithm>
+#include <string_view>
 
 #include <atomicdata.hpp>
 
@@ -7,15 +8,60 @@ using namespace eosio;
 using namespace std;
 using namespace atomicdata;
 
+
+/*
+64 bit FNV-1a hash of an attribute name
+Used to detect duplicate names without comparing every name with every other name
+*/
+constexpr uint64_t hash_attribute_name(std::string_view name) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (char c : name) {
+        hash ^= (uint8_t) c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+
+/*
+Checks a single format line and returns its compiled type code
+*/
+uint8_t check_format_line(const FORMAT &line) {
+    check(line.name.length() != 0, "An attribute's name can't be empty");
+    check(line.name.length() <= 64, "An attribute's name can only be 64 characters max");
+
+    uint8_t type = compile_type(line.type);
+    check(type != 0, "'type' attribute has an invalid format - " + line.type);
+
+    return type;
+}
+
+
+/*
+Returns the sorted name hashes of a format
+This is the index that is stored alongside formats, so that extensions can be checked against it
+*/
+vector <uint64_t> get_name_hashes(const vector <FORMAT> &lines) {
+    vector <uint64_t> name_hashes = {};
+    name_hashes.reserve(lines.size());
+    for (const FORMAT &line : lines) {
+        name_hashes.push_back(hash_attribute_name(line.name));
+    }
+    std::sort(name_hashes.begin(), name_hashes.end());
+    return name_hashes;
+}
+
+
 /*
 This function checks if a vector of FORMAT structs, used to describe a format, is valid
+It returns the compiled type code of each line, in the same order as the lines
 
 For a format to be valid, three things are checked:
 1. The type attribute has to be a valid type. Valid types are:
     int8 / int16 / int32 / int64
     uint8 / uint16 / uint32 / uint64
     fixed8 / fixed16 / fixed32 / fixed64
-    float / double / string / image / ipfs / bool / byte
+    float / double / string / image / ipfs / bool / bytes
 
     or any valid type followed by [] to describe a vector
     nested vectors (e.g. uint64[][]) are not allowed
@@ -26,72 +72,104 @@ For a format to be valid, three things are checked:
    This could obviously also be done automatically, but we believe that this could lead to confusion
 
 
-Note: This could all be done a lot cleaner by using regex or similar libraries
-      However, using them would bloat up the contract size significantly.
+Types are looked up in the TYPE_DEFINITIONS table, and uniqueness is checked by sorting the name hashes,
+so that only names with an equal hash ever have to be compared with each other.
 */
-void check_format(vector <FORMAT> lines) {
+vector <uint8_t> check_format(const vector <FORMAT> &lines) {
 
     bool found_name = false;
 
-    vector <string> attribute_names = {};
+    vector <uint8_t> types = {};
+    types.reserve(lines.size());
 
-    for (FORMAT line : lines) {
+    vector <pair <uint64_t, uint32_t>> name_hashes = {};
+    name_hashes.reserve(lines.size());
 
-        string name = line.name;
-        string type = line.type;
+    for (uint32_t i = 0; i < lines.size(); i++) {
+        const FORMAT &line = lines[i];
 
-        check(name.length() != 0, "An attribute's name can't be empty");
-        check(name.length() <= 64, "An attribute's name can only be 64 characters max");
+        uint8_t type = check_format_line(line);
 
-        if (name == "name" && type == "string") {
+        if (type == TYPE_STRING && line.name == "name") {
             found_name = true;
         }
 
-        size_t offset = 0;
-        bool found_num_type = false;
-        if (type.find("int", offset) == offset) {
-            offset += 3;
-            found_num_type = true;
-        } else if (type.find("uint", offset) == offset) {
-            offset += 4;
-            found_num_type = true;
-        } else if (type.find("fixed", offset) == offset) {
-            offset += 5;
-            found_num_type = true;
+        types.push_back(type);
+        name_hashes.emplace_back(hash_attribute_name(line.name), i);
+    }
+
+    std::sort(name_hashes.begin(), name_hashes.end());
+    for (uint32_t i = 1; i < name_hashes.size(); i++) {
+        const string &name = lines[name_hashes[i].second].name;
+        for (uint32_t j = i; j > 0 && name_hashes[j - 1].first == name_hashes[i].first; j--) {
+            check(lines[name_hashes[j - 1].second].name != name,
+                "there already is an attribute with the same name - " + name);
         }
-        if (found_num_type) {
-            if (type.find("8", offset) == offset) {
-                offset += 1;
-            } else if (type.find("16", offset) == offset || type.find("32", offset) == offset ||
-                       type.find("64", offset) == offset) {
-                offset += 2;
-            } else {
-                check(false, "'type' attribute has an invalid format - " + line.type);
-            }
-        } else {
-            if (type.find("bool", offset) == offset || type.find("ipfs", offset) == offset) {
-                offset += 4;
-            } else if (type.find("bytes", offset) == offset || type.find("float", offset) == offset ||
-                type.find("image", offset) == offset) {
-                offset += 5;
-            } else if (type.find("string", offset) == offset || type.find("double", offset) == offset) {
-                offset += 6;
-            } else {
-                check(false, "'type' attribute has an invalid format - " + line.type);
+    }
+
+    check(found_name,
+        "A format line with {\"name\": \"name\" and \"type\": \"string\"} needs to be defined for every schema");
+
+    return types;
+}
+
+
+/*
+Checks lines that are appended to an already valid format
+
+Only the new lines are validated. Their names are checked against name_hashes, which has to contain the
+sorted name hashes of the existing lines (see get_name_hashes), so the cost only depends on the size of the extension.
+The existing lines are only looked at if a new name has the same hash as an existing one.
+name_hashes is updated to also include the names of the new lines.
+
+Returns the compiled type code of each new line
+*/
+vector <uint8_t> check_format_extension(
+    const vector <FORMAT> &lines,
+    vector <uint64_t> &name_hashes,
+    const vector <FORMAT> &extension
+) {
+    if (lines.size() == 0) {
+        vector <uint8_t> types = check_format(extension);
+        name_hashes = get_name_hashes(extension);
+        return types;
+    }
+
+    vector <uint8_t> types = {};
+    types.reserve(extension.size());
+
+    vector <pair <uint64_t, uint32_t>> new_name_hashes = {};
+    new_name_hashes.reserve(extension.size());
+
+    for (uint32_t i = 0; i < extension.size(); i++) {
+        const FORMAT &line = extension[i];
+
+        types.push_back(check_format_line(line));
+
+        uint64_t hash = hash_attribute_name(line.name);
+        if (std::binary_search(name_hashes.begin(), name_hashes.end(), hash)) {
+            for (const FORMAT &existing_line : lines) {
+                check(existing_line.name != line.name,
+                    "there already is an attribute with the same name - " + line.name);
             }
         }
-        if (offset != type.length()) {
-            check(type.find("[]", offset) == offset, "'type' attribute has an invalid format - " + line.type);
-            offset += 2;
-        }
-        check(offset == type.length(), "'type' attribute has an invalid format - " + line.type);
+        new_name_hashes.emplace_back(hash, i);
+    }
 
-        check(std::find(attribute_names.begin(), attribute_names.end(), name) == attribute_names.end(),
-            "there already is an attribute with the same name - " + line.name);
+    std::sort(new_name_hashes.begin(), new_name_hashes.end());
+    for (uint32_t i = 1; i < new_name_hashes.size(); i++) {
+        const string &name = extension[new_name_hashes[i].second].name;
+        for (uint32_t j = i; j > 0 && new_name_hashes[j - 1].first == new_name_hashes[i].first; j--) {
+            check(extension[new_name_hashes[j - 1].second].name != name,
+                "there already is an attribute with the same name - " + name);
+        }
+    }
 
-        attribute_names.push_back(name);
+    size_t old_size = name_hashes.size();
+    for (const auto &[hash, index] : new_name_hashes) {
+        name_hashes.push_back(hash);
     }
+    std::inplace_merge(name_hashes.begin(), name_hashes.begin() + old_size, name_hashes.end());
 
-    check(found_name,
-        "A format line with {\"name\": \"name\" and \"type\": \"string\"} needs to be defined for every schema");
-}
\ No newline at end of file
+    return types;
+}
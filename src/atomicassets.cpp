@@ -2,13 +2,40 @@
 
 
 /**
-*  Initializes the config table. Only needs to be called once when first deploying the contract
+*  Initializes the config tables. Only needs to be called once when first deploying the contract
+*  When upgrading a contract that was deployed before the counters table existed, it moves the counters there
+*  It also sets the tokenconfigs version to the one of this contract, so that readers can detect the table layouts
 *  @required_auth The contract itself
 */
 ACTION atomicassets::init() {
     require_auth(get_self());
     config.get_or_create(get_self(), config_s{});
-    tokenconfigs.get_or_create(get_self(), tokenconfigs_s{});
+    tokenconfigs_s current_tokenconfigs = tokenconfigs.get_or_create(get_self(), tokenconfigs_s{});
+    if (current_tokenconfigs.version != tokenconfigs_s{}.version) {
+        current_tokenconfigs.version = tokenconfigs_s{}.version;
+        tokenconfigs.set(current_tokenconfigs, get_self());
+    }
+    if (!counters.exists()) {
+        counters.set(get_counters(), get_self());
+    }
+
+    //Supported tokens that were added before the suptokens table existed
+    //Only one token per symbol code can be supported. Others can't be deposited anymore, which is logged
+    for (const extended_symbol &token : config.get().supported_tokens) {
+        auto suptoken_itr = suptokens.find(token.get_symbol().code().raw());
+        if (suptoken_itr == suptokens.end()) {
+            suptokens.emplace(get_self(), [&](auto &_suptoken) {
+                _suptoken.token = token;
+            });
+        } else if (suptoken_itr->token != token) {
+            action(
+                permission_level{get_self(), name("active")},
+                get_self(),
+                name("logskiptoken"),
+                make_tuple(token, suptoken_itr->token)
+            ).send();
+        }
+    }
 }
 
 /**
@@ -21,12 +48,26 @@ ACTION atomicassets::admincoledit(vector <atomicdata::FORMAT> collection_format_
     check(collection_format_extension.size() != 0, "Need to add at least one new line");
 
     config_s current_config = config.get();
+
+    //Configs written before the name hashes were introduced don't have them yet
+    vector <uint64_t> name_hashes = current_config.collection_format_hashes.has_value()
+                                    ? current_config.collection_format_hashes.value()
+                                    : get_name_hashes(current_config.collection_format);
+    vector <uint8_t> type_codes = get_collection_format_types(current_config);
+    vector <uint8_t> extension_type_codes = check_format_extension(
+        current_config.collection_format,
+        name_hashes,
+        collection_format_extension
+    );
+    type_codes.insert(type_codes.end(), extension_type_codes.begin(), extension_type_codes.end());
+
     current_config.collection_format.insert(
         current_config.collection_format.end(),
         collection_format_extension.begin(),
         collection_format_extension.end()
     );
-    check_format(current_config.collection_format);
+    current_config.collection_format_hashes = name_hashes;
+    current_config.collection_format_types = type_codes;
 
     config.set(current_config, get_self());
 }
@@ -53,18 +94,33 @@ ACTION atomicassets::setversion(string new_version) {
 ACTION atomicassets::addconftoken(name token_contract, symbol token_symbol) {
     require_auth(get_self());
 
-    config_s current_config = config.get();
-    for (extended_symbol token : current_config.supported_tokens) {
-        check(token.get_symbol() != token_symbol,
-            "A token with this symbol is already supported");
-    }
+    check(suptokens.find(token_symbol.code().raw()) == suptokens.end(),
+        "A token with this symbol is already supported");
 
-    current_config.supported_tokens.push_back(extended_symbol(token_symbol, token_contract));
+    suptokens.emplace(get_self(), [&](auto &_suptoken) {
+        _suptoken.token = extended_symbol(token_symbol, token_contract);
+    });
 
+    //Also kept in the config for readers of the config table
+    config_s current_config = config.get();
+    current_config.supported_tokens.push_back(extended_symbol(token_symbol, token_contract));
     config.set(current_config, get_self());
 }
 
 
+/**
+*  Sets which of the optional contract features (FEATURE_* bits) are enabled
+*  Features only affect rows and logs written after they have been changed
+*  @required_auth The contract itself
+*/
+ACTION atomicassets::setfeatures(uint64_t enabled_features) {
+    require_auth(get_self());
+
+    features_s current_features = get_features();
+    features.set(features_s{enabled_features, current_features.used_features | enabled_features}, get_self());
+}
+
+
 /**
 *  Transfers one or more assets to another account
 *  @required_auth The from account
@@ -82,6 +138,71 @@ ACTION atomicassets::transfer(
 }
 
 
+/**
+*  Transfers assets from one account to multiple recipients
+*  Each transfer group has its own recipient, assets and memo. The assets of all groups are checked together,
+*  template lookups are shared between the groups and a single logtransfers action is sent per collection
+*  @required_auth The from account
+*/
+ACTION atomicassets::transfermulti(
+    name from,
+    vector <TRANSFER_GROUP> transfers
+) {
+    require_auth(from);
+    require_recipient(from);
+
+    check(transfers.size() != 0, "transfers needs to contain at least one transfer");
+
+    vector <uint64_t> all_asset_ids = {};
+    set <name> recipients = {};
+    for (const TRANSFER_GROUP &transfer : transfers) {
+        check(from != transfer.to, "Can't transfer assets to yourself");
+
+        check(transfer.asset_ids.size() != 0, "asset_ids needs to contain at least one id");
+
+        check(transfer.memo.length() <= 256, "A transfer memo can only be 256 characters max");
+
+        if (recipients.insert(transfer.to).second) {
+            check(is_account(transfer.to), "to account does not exist");
+            require_recipient(transfer.to);
+        }
+
+        all_asset_ids.insert(all_asset_ids.end(), transfer.asset_ids.begin(), transfer.asset_ids.end());
+    }
+
+    std::sort(all_asset_ids.begin(), all_asset_ids.end());
+    check(std::adjacent_find(all_asset_ids.begin(), all_asset_ids.end()) == all_asset_ids.end(),
+        "Can't transfer the same asset multiple times");
+
+    map <name, vector <TRANSFER_GROUP>> collection_to_transfers = {};
+
+    for (const TRANSFER_GROUP &transfer : transfers) {
+        map <name, vector <uint64_t>> collection_to_assets_transferred = internal_move_assets(
+            from,
+            transfer.to,
+            transfer.asset_ids,
+            from,
+            "Sender",
+            true
+        );
+
+        for (const auto&[collection, assets_transferred] : collection_to_assets_transferred) {
+            collection_to_transfers[collection].push_back({transfer.to, assets_transferred, transfer.memo});
+        }
+    }
+
+    //Sending notifications
+    for (const auto&[collection, collection_transfers] : collection_to_transfers) {
+        action(
+            permission_level{get_self(), name("active")},
+            get_self(),
+            name("logtransfers"),
+            make_tuple(collection, from, collection_transfers)
+        ).send();
+    }
+}
+
+
 /**
 *  Creates a new collection
 */
@@ -116,16 +237,27 @@ ACTION atomicassets::createcol(
 
     check(allow_notify || notify_accounts.size() == 0, "Can't add notify_accounts if allow_notify is false");
 
-    for (auto itr = authorized_accounts.begin(); itr != authorized_accounts.end(); itr++) {
-        check(is_account(*itr), string("At least one account does not exist - " + itr->to_string()).c_str());
-        check(std::find(authorized_accounts.begin(), authorized_accounts.end(), *itr) == itr,
-            "You can't have duplicates in the authorized_accounts");
+    for (const name &account : authorized_accounts) {
+        if (!is_account(account)) {
+            check(false, "At least one account does not exist - " + account.to_string());
+        }
     }
-    for (auto itr = notify_accounts.begin(); itr != notify_accounts.end(); itr++) {
-        check(is_account(*itr), string("At least one account does not exist - " + itr->to_string()).c_str());
-        check(std::find(notify_accounts.begin(), notify_accounts.end(), *itr) == itr,
-            "You can't have duplicates in the notify_accounts");
+    vector <name> authorized_accounts_copy = authorized_accounts;
+    std::sort(authorized_accounts_copy.begin(), authorized_accounts_copy.end());
+    check(std::adjacent_find(authorized_accounts_copy.begin(), authorized_accounts_copy.end()) ==
+          authorized_accounts_copy.end(),
+        "You can't have duplicates in the authorized_accounts");
+
+    for (const name &account : notify_accounts) {
+        if (!is_account(account)) {
+            check(false, "At least one account does not exist - " + account.to_string());
+        }
     }
+    vector <name> notify_accounts_copy = notify_accounts;
+    std::sort(notify_accounts_copy.begin(), notify_accounts_copy.end());
+    check(std::adjacent_find(notify_accounts_copy.begin(), notify_accounts_copy.end()) ==
+          notify_accounts_copy.end(),
+        "You can't have duplicates in the notify_accounts");
 
     check(0 <= market_fee && market_fee <= MAX_MARKET_FEE,
         "The market_fee must be between 0 and " + to_string(MAX_MARKET_FEE));
@@ -141,8 +273,19 @@ ACTION atomicassets::createcol(
         _collection.authorized_accounts = authorized_accounts;
         _collection.notify_accounts = notify_accounts;
         _collection.market_fee = market_fee;
-        _collection.serialized_data = serialize(data, current_config.collection_format);
+        _collection.serialized_data = serialize(
+            data,
+            current_config.collection_format,
+            get_collection_format_types(current_config)
+        );
     });
+
+    colauths_t collection_auths = get_collection_auths(collection_name);
+    for (const name &account : authorized_accounts) {
+        collection_auths.emplace(author, [&](auto &_auth) {
+            _auth.account = account;
+        });
+    }
 }
 
 
@@ -164,7 +307,11 @@ ACTION atomicassets::setcoldata(
 
     config_s current_config = config.get();
     collections.modify(collection_itr, same_payer, [&](auto &_collection) {
-        _collection.serialized_data = serialize(data, current_config.collection_format);
+        _collection.serialized_data = serialize(
+            data,
+            current_config.collection_format,
+            get_collection_format_types(current_config)
+        );
     });
 }
 
@@ -190,11 +337,17 @@ ACTION atomicassets::addcolauth(
           authorized_accounts.end(),
         "The account is already an authorized account");
 
+    internal_copy_collection_auths(*collection_itr);
+
     authorized_accounts.push_back(account_to_add);
 
     collections.modify(collection_itr, same_payer, [&](auto &_collection) {
         _collection.authorized_accounts = authorized_accounts;
     });
+
+    get_collection_auths(collection_name).emplace(collection_itr->author, [&](auto &_auth) {
+        _auth.account = account_to_add;
+    });
 }
 
 
@@ -218,9 +371,14 @@ ACTION atomicassets::remcolauth(
         "The account is not an authorized account");
     authorized_accounts.erase(account_itr);
 
+    internal_copy_collection_auths(*collection_itr);
+
     collections.modify(collection_itr, same_payer, [&](auto &_collection) {
         _collection.authorized_accounts = authorized_accounts;
     });
+
+    colauths_t collection_auths = get_collection_auths(collection_name);
+    collection_auths.erase(collection_auths.find(account_to_remove.value));
 }
 
 
@@ -253,6 +411,9 @@ ACTION atomicassets::addnotifyacc(
 
     collections.modify(collection_itr, same_payer, [&](auto &_collection) {
         _collection.notify_accounts = notify_accounts;
+        if (_collection.notify_events.has_value()) {
+            _collection.notify_events.value().push_back(NOTIFY_ALL);
+        }
     });
 }
 
@@ -275,10 +436,15 @@ ACTION atomicassets::remnotifyacc(
 
     check(account_itr != notify_accounts.end(),
         "The account is not a notify account");
+    size_t account_index = account_itr - notify_accounts.begin();
     notify_accounts.erase(account_itr);
 
     collections.modify(collection_itr, same_payer, [&](auto &_collection) {
         _collection.notify_accounts = notify_accounts;
+        if (_collection.notify_events.has_value()) {
+            vector <uint8_t> &notify_events = _collection.notify_events.value();
+            notify_events.erase(notify_events.begin() + account_index);
+        }
     });
 }
 
@@ -328,6 +494,35 @@ ACTION atomicassets::forbidnotify(
 }
 
 
+/**
+*  Sets the events that a notify account of a collection is notified about
+*  events is a bitmask of the NOTIFY_* events. Notify accounts that never had their events set get all events
+*  @required_auth The collection author
+*/
+ACTION atomicassets::setnotifyflt(
+    name collection_name,
+    name notify_account,
+    uint8_t events
+) {
+    auto collection_itr = collections.require_find(collection_name.value,
+        "No collection with this name exists");
+
+    require_auth(collection_itr->author);
+
+    const vector <name> &notify_accounts = collection_itr->notify_accounts;
+    auto account_itr = std::find(notify_accounts.begin(), notify_accounts.end(), notify_account);
+    check(account_itr != notify_accounts.end(), "The account is not a notify account");
+    size_t account_index = account_itr - notify_accounts.begin();
+
+    collections.modify(collection_itr, same_payer, [&](auto &_collection) {
+        if (!_collection.notify_events.has_value()) {
+            _collection.notify_events.emplace(_collection.notify_accounts.size(), NOTIFY_ALL);
+        }
+        _collection.notify_events.value()[account_index] = events;
+    });
+}
+
+
 /**
 *  Creates a new schema
 *  schemas can only be extended in the future, but never changed retroactively.
@@ -359,11 +554,13 @@ ACTION atomicassets::createschema(
     check(collection_schemas.find(schema_name.value) == collection_schemas.end(),
         "A schema with this name already exists for this collection");
 
-    check_format(schema_format);
+    vector <uint8_t> type_codes = check_format(schema_format);
 
     collection_schemas.emplace(authorized_creator, [&](auto &_schema) {
         _schema.schema_name = schema_name;
         _schema.format = schema_format;
+        _schema.name_hashes = get_name_hashes(schema_format);
+        _schema.type_codes = type_codes;
     });
 }
 
@@ -395,12 +592,22 @@ ACTION atomicassets::extendschema(
     auto schema_itr = collection_schemas.require_find(schema_name.value,
         "No schema with this name exists for this collection");
 
-    vector <FORMAT> lines = schema_itr->format;
-    lines.insert(lines.end(), schema_format_extension.begin(), schema_format_extension.end());
-    check_format(lines);
+    //Schemas created before the name hashes were introduced don't have them yet
+    vector <uint64_t> name_hashes = schema_itr->name_hashes.has_value()
+                                    ? schema_itr->name_hashes.value()
+                                    : get_name_hashes(schema_itr->format);
+    vector <uint8_t> type_codes = get_schema_type_codes(*schema_itr);
+    vector <uint8_t> extension_type_codes = check_format_extension(
+        schema_itr->format,
+        name_hashes,
+        schema_format_extension
+    );
+    type_codes.insert(type_codes.end(), extension_type_codes.begin(), extension_type_codes.end());
 
     collection_schemas.modify(schema_itr, authorized_editor, [&](auto &_schema) {
-        _schema.format = lines;
+        _schema.format.insert(_schema.format.end(), schema_format_extension.begin(), schema_format_extension.end());
+        _schema.name_hashes = name_hashes;
+        _schema.type_codes = type_codes;
     });
 }
 
@@ -433,12 +640,21 @@ ACTION atomicassets::createtempl(
     auto schema_itr = collection_schemas.require_find(schema_name.value,
         "No schema with this name exists");
 
-    config_s current_config = config.get();
-    int32_t template_id = current_config.template_counter++;
-    config.set(current_config, get_self());
+    counters_s current_counters = get_counters();
+    int32_t template_id = current_counters.template_counter++;
+    counters.set(current_counters, get_self());
 
     templates_t collection_templates = get_templates(collection_name);
 
+    vector <uint8_t> immutable_serialized_data = serialize(
+        immutable_data,
+        schema_itr->format,
+        get_schema_type_codes(*schema_itr)
+    );
+    uint64_t immutable_blob_id;
+    bool use_blob = is_feature_enabled(FEATURE_SHARED_BLOBS)
+                    && internal_store_blob(collection_name, immutable_serialized_data, authorized_creator, immutable_blob_id);
+
     collection_templates.emplace(authorized_creator, [&](auto &_template) {
         _template.template_id = template_id;
         _template.schema_name = schema_name;
@@ -446,7 +662,20 @@ ACTION atomicassets::createtempl(
         _template.burnable = burnable;
         _template.max_supply = max_supply;
         _template.issued_supply = 0;
-        _template.immutable_serialized_data = serialize(immutable_data, schema_itr->format);
+        if (use_blob) {
+            _template.immutable_serialized_data = {};
+            _template.immutable_blob_id.emplace(immutable_blob_id);
+        } else {
+            _template.immutable_serialized_data = std::move(immutable_serialized_data);
+        }
+    });
+
+    get_supplies(collection_name).emplace(authorized_creator, [&](auto &_supply) {
+        _supply.template_id = template_id;
+        _supply.issued_supply = 0;
+        _supply.burned_supply = 0;
+        _supply.reserved_supply = 0;
+        _supply.locked = false;
     });
 
     action(
@@ -494,12 +723,24 @@ ACTION atomicassets::locktemplate(
     auto template_itr = collection_templates.require_find(template_id,
         "No template with the specified id exists for the specified collection");
 
-    check(template_itr->issued_supply != 0,
-        "Can't lock a template that does not have at least one issued asset");
+    //Assets reserved by open airdrops still need to be mintable
+    supplies_s template_supply = get_template_supply(collection_name, *template_itr);
+    uint32_t locked_supply = template_supply.issued_supply + template_supply.reserved_supply;
+    check(locked_supply != 0,
+        "Can't lock a template that does not have at least one issued or reserved asset");
 
     collection_templates.modify(template_itr, same_payer, [&](auto &_template) {
-        _template.max_supply = _template.issued_supply;
+        _template.max_supply = locked_supply;
     });
+
+    //Templates without a supplies row have no reserved supply, so their max_supply alone prevents any further mints
+    supplies_t collection_supplies = get_supplies(collection_name);
+    auto supply_itr = collection_supplies.find(template_id);
+    if (supply_itr != collection_supplies.end()) {
+        collection_supplies.modify(supply_itr, same_payer, [&](auto &_supply) {
+            _supply.locked = true;
+        });
+    }
 }
 
 
@@ -521,98 +762,36 @@ ACTION atomicassets::mintasset(
 ) {
     require_auth(authorized_minter);
 
-    auto collection_itr = collections.find(collection_name.value);
-
-    check_has_collection_auth(
+    internal_mint_assets(
         authorized_minter,
         collection_name,
-        "The minter is not authorized within the collection"
+        schema_name,
+        template_id,
+        {{new_asset_owner, immutable_data, mutable_data, tokens_to_back}},
+        false
     );
+}
 
-    schemas_t collection_schemas = get_schemas(collection_name);
-    auto schema_itr = collection_schemas.require_find(schema_name.value,
-        "No schema with this name exists");
-
-    //Needed for the log action
-    ATTRIBUTE_MAP deserialized_template_data;
-    if (template_id >= 0) {
-        templates_t collection_templates = get_templates(collection_name);
-
-        auto template_itr = collection_templates.require_find(template_id,
-            "No template with this id exists");
-
-        check(template_itr->schema_name == schema_name,
-            "The template belongs to another schema");
-
-        if (template_itr->max_supply > 0) {
-            check(template_itr->issued_supply < template_itr->max_supply,
-                "The template's maxsupply has already been reached");
-        }
-        collection_templates.modify(template_itr, same_payer, [&](auto &_template) {
-            _template.issued_supply += 1;
-        });
-
-        deserialized_template_data = deserialize(
-            template_itr->immutable_serialized_data,
-            schema_itr->format
-        );
-    } else {
-        check(template_id == -1, "The template id must either be an existing template or -1");
-
-        deserialized_template_data = {};
-    }
-
-    check(is_account(new_asset_owner), "The new_asset_owner account does not exist");
-
-    check_name_length(immutable_data);
-    check_name_length(mutable_data);
-
-    config_s current_config = config.get();
-    uint64_t asset_id = current_config.asset_counter++;
-    config.set(current_config, get_self());
-
-    assets_t new_owner_assets = get_assets(new_asset_owner);
-    new_owner_assets.emplace(authorized_minter, [&](auto &_asset) {
-        _asset.asset_id = asset_id;
-        _asset.collection_name = collection_name;
-        _asset.schema_name = schema_name;
-        _asset.template_id = template_id;
-        _asset.ram_payer = authorized_minter;
-        _asset.backed_tokens = {};
-        _asset.immutable_serialized_data = serialize(immutable_data, schema_itr->format);
-        _asset.mutable_serialized_data = serialize(mutable_data, schema_itr->format);
-    });
 
+/**
+*  Creates multiple new assets of the same collection, schema and template in one action
+*  This is a lot cheaper per asset than calling mintasset for each asset, because the schema, the template
+*  and the minter's authorization are only checked once for all assets
+*  @required_auth authorized_minter, who is within the authorized_accounts list of the collection
+                  specified in the related template
+*/
+ACTION atomicassets::mintassets(
+    name authorized_minter,
+    name collection_name,
+    name schema_name,
+    int32_t template_id,
+    vector <MINT_DATA> assets_to_mint
+) {
+    require_auth(authorized_minter);
 
-    action(
-        permission_level{get_self(), name("active")},
-        get_self(),
-        name("logmint"),
-        make_tuple(
-            asset_id,
-            authorized_minter,
-            collection_name,
-            schema_name,
-            template_id,
-            new_asset_owner,
-            immutable_data,
-            mutable_data,
-            tokens_to_back,
-            deserialized_template_data
-        )
-    ).send();
+    check(assets_to_mint.size() != 0, "Need to mint at least one asset");
 
-    //Calls the internal_back_asset function which handles asset backing.
-    //It will throw if authorized_minter does not have a sufficient balance to pay for the backed tokens
-    //Token validity must not be cross-checked with config.supported_tokens because it's implicitly checked
-    //when decreasing minter's balance (only supported tokens can be deposited)
-    set <symbol> used_symbols = {};
-    for (asset &token : tokens_to_back) {
-        check(used_symbols.find(token.symbol) == used_symbols.end(),
-            "Symbols in the tokens_to_back must be unique");
-        used_symbols.emplace(token.symbol);
-        internal_back_asset(authorized_minter, new_asset_owner, asset_id, token);
-    }
+    internal_mint_assets(authorized_minter, collection_name, schema_name, template_id, assets_to_mint, false);
 }
 
 
@@ -629,136 +808,398 @@ ACTION atomicassets::setassetdata(
 ) {
     require_auth(authorized_editor);
 
-    assets_t owner_assets = get_assets(asset_owner);
-
-    auto asset_itr = owner_assets.require_find(asset_id,
-        "No asset with this id exists");
-
-    auto collection_itr = collections.find(asset_itr->collection_name.value);
+    assets_s owner_asset;
+    check(find_asset(asset_owner, asset_id, owner_asset), "No asset with this id exists");
 
     check_has_collection_auth(
         authorized_editor,
-        asset_itr->collection_name,
+        owner_asset.collection_name,
         "The editor is not authorized within the collection"
     );
 
     check_name_length(new_mutable_data);
 
-    schemas_t collection_schemas = get_schemas(asset_itr->collection_name);
-    auto schema_itr = collection_schemas.find(asset_itr->schema_name.value);
+    name schema_name = get_asset_schema(owner_asset);
+    schemas_t collection_schemas = get_schemas(owner_asset.collection_name);
+    auto schema_itr = collection_schemas.find(schema_name.value);
 
-    ATTRIBUTE_MAP deserialized_old_data = deserialize(
-        asset_itr->mutable_serialized_data,
-        schema_itr->format
-    );
+    vector <uint8_t> type_codes = get_schema_type_codes(*schema_itr);
 
-    action(
-        permission_level{get_self(), name("active")},
-        get_self(),
-        name("logsetdata"),
-        make_tuple(asset_owner, asset_id, deserialized_old_data, new_mutable_data)
-    ).send();
+    vector <uint8_t> new_serialized_data = serialize(new_mutable_data, schema_itr->format, type_codes);
 
+    if (is_feature_enabled(FEATURE_RAW_DATA_LOGS)) {
+        action(
+            permission_level{get_self(), name("active")},
+            get_self(),
+            name("logsetraw"),
+            make_tuple(
+                asset_owner,
+                asset_id,
+                owner_asset.collection_name,
+                schema_name,
+                owner_asset.mutable_serialized_data,
+                new_serialized_data
+            )
+        ).send();
+    } else {
+        ATTRIBUTE_MAP deserialized_old_data = deserialize(
+            owner_asset.mutable_serialized_data,
+            schema_itr->format,
+            type_codes
+        );
 
-    owner_assets.modify(asset_itr, authorized_editor, [&](auto &_asset) {
-        _asset.ram_payer = authorized_editor;
-        _asset.mutable_serialized_data = serialize(new_mutable_data, schema_itr->format);
-    });
+        action(
+            permission_level{get_self(), name("active")},
+            get_self(),
+            name("logsetdata"),
+            make_tuple(asset_owner, asset_id, deserialized_old_data, new_mutable_data)
+        ).send();
+    }
+
+
+    owner_asset.ram_payer = authorized_editor;
+    owner_asset.mutable_serialized_data = std::move(new_serialized_data);
+    internal_update_asset(asset_owner, owner_asset);
 }
 
 
 /**
-* This action is used to add a zero value asset to the quantities vector of owner in the balances table
-* If no row exists for owner, a new one is created
-* This action needs to be called before transferring (depositing) any tokens to the AtomicAssets smart contract,
-* in order to pay for the RAM that otherwise would have to be paid by the AtomicAssets smart contract
+*  Registers an airdrop of assets of the specified template to a list of recipients
+*  The assets are not minted in this action, but in batches with the permissionless crank action.
 *
-* To pass a symbol to eosio as a string, use the following format: <precision>,<symbol_code>
-* So for example: "8,WAX"
-*
-* @required_auth owner
+*  The authorized_minter pays for the RAM of the assets upfront: The recipients are stored in chunks which
+*  include a RAM reserve big enough for the assets minted to them (including a new scope for every recipient).
+*  This reserve is freed again while the airdrop is cranked, which is why the assets can be billed to
+*  authorized_minter without their authorization. Unused reserve is refunded when a chunk is finished.
+*  @required_auth authorized_minter, who is within the authorized_accounts list of the collection
 */
-ACTION atomicassets::announcedepo(
-    name owner,
-    symbol symbol_to_announce
+ACTION atomicassets::createdrop(
+    name authorized_minter,
+    name collection_name,
+    name schema_name,
+    int32_t template_id,
+    vector <name> recipients
 ) {
-    require_auth(owner);
+    require_auth(authorized_minter);
 
-    config_s current_config = config.get();
+    check_has_collection_auth(
+        authorized_minter,
+        collection_name,
+        "The minter is not authorized within the collection"
+    );
 
-    bool is_supported = false;
-    for (extended_symbol supported_token : current_config.supported_tokens) {
-        if (supported_token.get_symbol() == symbol_to_announce) {
-            is_supported = true;
-            break;
-        }
-    }
-    check(is_supported, "The specified symbol is not supported");
+    check(template_id >= 0, "Airdrops need to use a template");
 
-    auto balance_itr = balances.find(owner.value);
+    templates_t collection_templates = get_templates(collection_name);
+    auto template_itr = collection_templates.require_find(template_id,
+        "No template with this id exists");
+
+    check(template_itr->schema_name == schema_name,
+        "The template belongs to another schema");
+
+    //Cranks aren't authorized by the minter, so the supplies row has to exist before the first crank
+    internal_init_template_supply(collection_name, *template_itr, authorized_minter);
+
+    uint64_t airdrop_id = airdrops.available_primary_key();
+    airdrops.emplace(authorized_minter, [&](auto &_airdrop) {
+        _airdrop.airdrop_id = airdrop_id;
+        _airdrop.collection_name = collection_name;
+        _airdrop.schema_name = schema_name;
+        _airdrop.template_id = template_id;
+        _airdrop.authorized_minter = authorized_minter;
+        _airdrop.assets_minted = 0;
+        _airdrop.assets_remaining = 0;
+    });
 
-    if (balance_itr == balances.end()) {
-        vector <asset> quantities = {asset(0, symbol_to_announce)};
-        balances.emplace(owner, [&](auto &_balance) {
-            _balance.owner = owner;
-            _balance.quantities = quantities;
-        });
+    internal_add_airdrop_recipients(airdrop_id, authorized_minter, recipients);
+}
 
-    } else {
-        vector <asset> quantities = balance_itr->quantities;
-        for (asset &token : quantities) {
-            if (token.symbol == symbol_to_announce) {
-                //The symbol has already been announced
-                return;
-            }
-        }
-        quantities.push_back(asset(0, symbol_to_announce));
 
-        balances.modify(balance_itr, owner, [&](auto &_balance) {
-            _balance.quantities = quantities;
-        });
-    }
+/**
+*  Adds more recipients to an existing airdrop
+*  This is needed for airdrops that have too many recipients to fit into a single transaction
+*  @required_auth The airdrop's authorized_minter
+*/
+ACTION atomicassets::extenddrop(
+    uint64_t airdrop_id,
+    vector <name> recipients
+) {
+    auto airdrop_itr = airdrops.require_find(airdrop_id,
+        "No airdrop with this id exists");
+
+    require_auth(airdrop_itr->authorized_minter);
+
+    internal_add_airdrop_recipients(airdrop_id, airdrop_itr->authorized_minter, recipients);
 }
 
 
 /**
-* Withdraws fungible tokens that were previously deposited
-*
-* @required_auth owner
+*  Mints the assets for the next (up to) max_assets recipients of an airdrop
+*  Each call continues where the previous one stopped, and the airdrop is erased once all assets are minted.
+*  The RAM of the assets is paid for by the RAM reserve of the airdrop's chunks, see createdrop.
+*  @required_auth None
 */
-ACTION atomicassets::withdraw(
-    name owner,
-    asset token_to_withdraw
+ACTION atomicassets::crank(
+    uint64_t airdrop_id,
+    uint32_t max_assets
 ) {
-    require_auth(owner);
+    check(max_assets != 0, "max_assets needs to be at least 1");
 
-    check(token_to_withdraw.amount > 0, "token_to_withdraw must be positive");
+    auto airdrop_itr = airdrops.require_find(airdrop_id,
+        "No airdrop with this id exists");
 
-    //The internal_decrease_balance function will throw if owner does not have a sufficient balance
-    internal_decrease_balance(owner, token_to_withdraw);
+    dropchunks_t airdrop_chunks = get_airdrop_chunks(airdrop_id);
+    check(airdrop_chunks.begin() != airdrop_chunks.end(), "The airdrop does not have any recipients");
 
-    config_s current_config = config.get();
+    uint64_t asset_ram = get_airdrop_asset_ram(use_compact_assets(), use_global_assets());
+    uint64_t scope_ram = get_asset_scope_ram(use_compact_assets(), use_global_assets());
 
-    for (extended_symbol supported_token : current_config.supported_tokens) {
-        if (supported_token.get_symbol() == token_to_withdraw.symbol) {
-            action(
-                permission_level{get_self(), name("active")},
-                supported_token.get_contract(),
-                name("transfer"),
-                make_tuple(
-                    get_self(),
-                    owner,
-                    token_to_withdraw,
-                    string("Withdrawal")
-                )
-            ).send();
-            break;
-        }
-    }
-}
+    vector <MINT_DATA> assets_to_mint = {};
+    set <name> new_scopes = {};
 
+    auto chunk_itr = airdrop_chunks.begin();
+    while (chunk_itr != airdrop_chunks.end() && assets_to_mint.size() < max_assets) {
+        uint64_t ram_reserve = chunk_itr->ram_reserve.size();
 
-/**
+        uint64_t recipients_done = 0;
+        for (const name &recipient : chunk_itr->recipients) {
+            if (assets_to_mint.size() == max_assets) {
+                break;
+            }
+
+            //All assets in the globalassets table share the scope of the contract
+            name scope_owner = use_global_assets() ? get_self() : recipient;
+            uint64_t ram_cost = asset_ram;
+            if (new_scopes.find(scope_owner) == new_scopes.end()) {
+                if (!asset_scope_exists(recipient)) {
+                    ram_cost += scope_ram;
+                    new_scopes.insert(scope_owner);
+                }
+            }
+            check(ram_reserve >= ram_cost,
+                "The RAM reserve of the airdrop is too small for the enabled asset storage, see topupdrop");
+            ram_reserve -= ram_cost;
+
+            assets_to_mint.push_back({recipient, {}, {}, {}});
+            recipients_done++;
+        }
+
+        if (recipients_done == chunk_itr->recipients.size()) {
+            chunk_itr = airdrop_chunks.erase(chunk_itr);
+        } else {
+            airdrop_chunks.modify(chunk_itr, same_payer, [&](auto &_chunk) {
+                _chunk.recipients.erase(_chunk.recipients.begin(), _chunk.recipients.begin() + recipients_done);
+                _chunk.ram_reserve.resize(ram_reserve);
+            });
+        }
+    }
+
+    internal_mint_assets(
+        airdrop_itr->authorized_minter,
+        airdrop_itr->collection_name,
+        airdrop_itr->schema_name,
+        airdrop_itr->template_id,
+        assets_to_mint,
+        true
+    );
+
+    if (airdrop_chunks.begin() == airdrop_chunks.end()) {
+        airdrops.erase(airdrop_itr);
+    } else {
+        airdrops.modify(airdrop_itr, same_payer, [&](auto &_airdrop) {
+            _airdrop.assets_minted += assets_to_mint.size();
+            _airdrop.assets_remaining -= assets_to_mint.size();
+        });
+    }
+}
+
+
+/**
+*  Cancels an airdrop, erasing all recipients that have not received their asset yet
+*  The remaining RAM reserve is refunded to the airdrop's authorized_minter
+*  @required_auth The airdrop's authorized_minter
+*/
+ACTION atomicassets::canceldrop(
+    uint64_t airdrop_id
+) {
+    auto airdrop_itr = airdrops.require_find(airdrop_id,
+        "No airdrop with this id exists");
+
+    require_auth(airdrop_itr->authorized_minter);
+
+    dropchunks_t airdrop_chunks = get_airdrop_chunks(airdrop_id);
+    auto chunk_itr = airdrop_chunks.begin();
+    while (chunk_itr != airdrop_chunks.end()) {
+        chunk_itr = airdrop_chunks.erase(chunk_itr);
+    }
+
+    templates_t collection_templates = get_templates(airdrop_itr->collection_name);
+    auto template_itr = collection_templates.find(airdrop_itr->template_id);
+    internal_reserve_template_supply(
+        airdrop_itr->collection_name,
+        *template_itr,
+        -(int64_t) airdrop_itr->assets_remaining
+    );
+
+    //A locked template's max_supply included the released assets, which can't be minted anymore
+    if (get_template_supply(airdrop_itr->collection_name, *template_itr).locked) {
+        collection_templates.modify(template_itr, same_payer, [&](auto &_template) {
+            _template.max_supply -= airdrop_itr->assets_remaining;
+        });
+    }
+
+    airdrops.erase(airdrop_itr);
+}
+
+
+/**
+*  Tops up the RAM reserve of the next (up to) max_chunks chunks of an airdrop
+*  Airdrops that were created before the enabled asset storage needed as much RAM per asset can't be cranked
+*  otherwise, because crank can't bill more RAM to the minter than the reserve holds
+*  @required_auth The airdrop's authorized_minter
+*/
+ACTION atomicassets::topupdrop(
+    uint64_t airdrop_id,
+    uint32_t max_chunks
+) {
+    check(max_chunks != 0, "max_chunks needs to be at least 1");
+
+    auto airdrop_itr = airdrops.require_find(airdrop_id,
+        "No airdrop with this id exists");
+
+    require_auth(airdrop_itr->authorized_minter);
+
+    uint64_t ram_per_recipient = get_airdrop_recipient_ram();
+
+    dropchunks_t airdrop_chunks = get_airdrop_chunks(airdrop_id);
+    auto chunk_itr = airdrop_chunks.begin();
+
+    uint32_t topped_up = 0;
+    for (uint32_t looked_at = 0; looked_at < max_chunks && chunk_itr != airdrop_chunks.end(); looked_at++) {
+        uint64_t needed_reserve = chunk_itr->recipients.size() * ram_per_recipient;
+        if (chunk_itr->ram_reserve.size() < needed_reserve) {
+            airdrop_chunks.modify(chunk_itr, same_payer, [&](auto &_chunk) {
+                _chunk.ram_reserve.resize(needed_reserve);
+            });
+            topped_up++;
+        }
+        chunk_itr++;
+    }
+
+    check(topped_up != 0, "The RAM reserve of the looked at chunks is already large enough");
+}
+
+
+/**
+* This action is used to add a zero value balance row for the specified symbol to the balances of owner
+* This action needs to be called before transferring (depositing) any tokens to the AtomicAssets smart contract,
+* in order to pay for the RAM that otherwise would have to be paid by the AtomicAssets smart contract
+*
+* To pass a symbol to eosio as a string, use the following format: <precision>,<symbol_code>
+* So for example: "8,WAX"
+*
+* @required_auth owner
+*/
+ACTION atomicassets::announcedepo(
+    name owner,
+    symbol symbol_to_announce
+) {
+    require_auth(owner);
+
+    get_supported_token(symbol_to_announce);
+
+    internal_migrate_balance(owner);
+
+    symbalances_t owner_balances = get_symbol_balances(owner);
+    if (owner_balances.find(symbol_to_announce.code().raw()) != owner_balances.end()) {
+        //The symbol has already been announced
+        return;
+    }
+
+    owner_balances.emplace(owner, [&](auto &_balance) {
+        _balance.quantity = asset(0, symbol_to_announce);
+    });
+}
+
+
+/**
+* Withdraws fungible tokens that were previously deposited
+*
+* @required_auth owner
+*/
+ACTION atomicassets::withdraw(
+    name owner,
+    asset token_to_withdraw
+) {
+    require_auth(owner);
+
+    check(token_to_withdraw.amount > 0, "token_to_withdraw must be positive");
+
+    //The internal_decrease_balance function will throw if owner does not have a sufficient balance
+    internal_decrease_balance(owner, token_to_withdraw);
+
+    action(
+        permission_level{get_self(), name("active")},
+        get_supported_token(token_to_withdraw.symbol).get_contract(),
+        name("transfer"),
+        make_tuple(
+            get_self(),
+            owner,
+            token_to_withdraw,
+            string("Withdrawal")
+        )
+    ).send();
+}
+
+
+/**
+*  Withdraws all fungible tokens that the owner has deposited and not spent yet
+*  This also removes all of the owner's balance rows, including announced symbols without a balance
+*  @required_auth owner
+*/
+ACTION atomicassets::withdrawall(
+    name owner
+) {
+    require_auth(owner);
+
+    internal_migrate_balance(owner);
+
+    symbalances_t owner_balances = get_symbol_balances(owner);
+    //Quantities that share their symbol code with a symbalances row stay in the balances table
+    auto legacy_balance_itr = balances.find(owner.value);
+    check(owner_balances.begin() != owner_balances.end() || legacy_balance_itr != balances.end(),
+        "The specified account does not have any balances");
+
+    vector <asset> quantities = {};
+    for (auto balance_itr = owner_balances.begin(); balance_itr != owner_balances.end();) {
+        quantities.push_back(balance_itr->quantity);
+        balance_itr = owner_balances.erase(balance_itr);
+    }
+    if (legacy_balance_itr != balances.end()) {
+        quantities.insert(quantities.end(),
+            legacy_balance_itr->quantities.begin(), legacy_balance_itr->quantities.end());
+        balances.erase(legacy_balance_itr);
+    }
+
+    for (const asset &quantity : quantities) {
+        if (quantity.amount > 0) {
+            action(
+                permission_level{get_self(), name("active")},
+                get_supported_token(quantity.symbol).get_contract(),
+                name("transfer"),
+                make_tuple(
+                    get_self(),
+                    owner,
+                    quantity,
+                    string("Withdrawal")
+                )
+            ).send();
+        }
+    }
+}
+
+
+/**
 * Backs an asset with a fungible token that was previously deposited by payer
 * payer also pays for the full RAM of the asset that is backed
 * 
@@ -776,6 +1217,81 @@ ACTION atomicassets::backasset(
 }
 
 
+/**
+* Backs multiple assets of the same owner with fungible tokens that were previously deposited by payer
+* The payer's balance is only decreased once per symbol and every asset row is only written once,
+* even if it is backed with multiple tokens
+* payer also pays for the full RAM of the assets that are backed
+*
+* @required_auth payer
+*/
+ACTION atomicassets::backassets(
+    name payer,
+    name asset_owner,
+    vector <ASSET_BACKING> backings
+) {
+    require_auth(payer);
+
+    check(backings.size() != 0, "backings needs to contain at least one entry");
+
+    auto add_token = [](vector <asset> &tokens, const asset &token_to_add) {
+        for (asset &token : tokens) {
+            if (token.symbol == token_to_add.symbol) {
+                token += token_to_add;
+                return;
+            }
+        }
+        tokens.push_back(token_to_add);
+    };
+
+    map <uint64_t, vector <asset>> asset_to_added_tokens = {};
+    vector <asset> total_tokens = {};
+    for (const ASSET_BACKING &backing : backings) {
+        check(backing.token_to_back.amount > 0, "token_to_back must be positive");
+
+        add_token(asset_to_added_tokens[backing.asset_id], backing.token_to_back);
+        add_token(total_tokens, backing.token_to_back);
+    }
+
+    //The internal_decrease_balance function will throw if payer does not have a sufficient balance
+    for (const asset &total_token : total_tokens) {
+        internal_decrease_balance(payer, total_token);
+    }
+
+    vector <BACKED_ASSET> backed_assets = {};
+    backed_assets.reserve(asset_to_added_tokens.size());
+
+    for (const auto &[asset_id, added_tokens] : asset_to_added_tokens) {
+        assets_s owner_asset;
+        if (!find_asset(asset_owner, asset_id, owner_asset)) {
+            check(false, "The specified owner does not own at least one of the assets (ID: " +
+                         to_string(asset_id) + ")");
+        }
+
+        if (!get_asset_flags(owner_asset).burnable) {
+            check(false, "At least one asset isn't burnable (ID: " + to_string(asset_id) +
+                         "). Only burnable assets can be backed.");
+        }
+
+        for (const asset &added_token : added_tokens) {
+            add_token(owner_asset.backed_tokens, added_token);
+        }
+
+        owner_asset.ram_payer = payer;
+        internal_update_asset(asset_owner, owner_asset);
+
+        backed_assets.push_back({asset_id, owner_asset.collection_name, added_tokens});
+    }
+
+    action(
+        permission_level{get_self(), name("active")},
+        get_self(),
+        name("logbackbatch"),
+        make_tuple(payer, asset_owner, backed_assets)
+    ).send();
+}
+
+
 /**
 *  Burns (deletes) an asset
 *  Only works if the "burnable" bool in the related template is true
@@ -788,81 +1304,229 @@ ACTION atomicassets::burnasset(
 ) {
     require_auth(asset_owner);
 
-    assets_t owner_assets = get_assets(asset_owner);
-    auto asset_itr = owner_assets.require_find(asset_id,
-        "No asset with this id exists for this owner");
+    assets_s owner_asset;
+    check(find_asset(asset_owner, asset_id, owner_asset), "No asset with this id exists for this owner");
 
-    if (asset_itr->template_id >= 0) {
-        templates_t collection_templates = get_templates(asset_itr->collection_name);
+    check(get_asset_flags(owner_asset).burnable, "The asset is not burnable");
 
-        auto template_itr = collection_templates.find(asset_itr->template_id);
-        check(template_itr->burnable, "The asset is not burnable");
-    };
 
+    if (owner_asset.backed_tokens.size() != 0) {
+        internal_increase_balance(asset_owner, owner_asset.backed_tokens);
+    }
 
-    if (asset_itr->backed_tokens.size() != 0) {
-        auto balance_itr = balances.find(asset_owner.value);
-        if (balance_itr == balances.end()) {
-            // If the asset_owner does not have a balance table entry yet, a new one is created
-            balances.emplace(asset_owner, [&](auto &_balance) {
-                _balance.owner = asset_owner,
-                _balance.quantities = asset_itr->backed_tokens;
-            });
-        } else {
-            // Any backed tokens are added to the asset_owners balance
-            vector <asset> quantities = balance_itr->quantities;
-
-            for (asset backed_quantity : asset_itr->backed_tokens) {
-                bool found_token = false;
-                for (asset &token : quantities) {
-                    if (token.symbol == backed_quantity.symbol) {
-                        found_token = true;
-                        token.amount += backed_quantity.amount;
-                        break;
-                    }
-                }
-                if (!found_token) {
-                    quantities.push_back(backed_quantity);
-                }
-            }
+    vector <uint8_t> immutable_serialized_data = get_immutable_data(owner_asset);
+    name schema_name = get_asset_schema(owner_asset);
 
-            balances.modify(balance_itr, asset_owner, [&](auto &_balance) {
-                _balance.quantities = quantities;
-            });
-        }
+    if (is_feature_enabled(FEATURE_RAW_DATA_LOGS)) {
+        action(
+            permission_level{get_self(), name("active")},
+            get_self(),
+            name("logburnraw"),
+            make_tuple(
+                asset_owner,
+                asset_id,
+                owner_asset.collection_name,
+                schema_name,
+                owner_asset.template_id,
+                owner_asset.backed_tokens,
+                immutable_serialized_data,
+                owner_asset.mutable_serialized_data,
+                owner_asset.ram_payer
+            )
+        ).send();
+    } else {
+        schemas_t collection_schemas = get_schemas(owner_asset.collection_name);
+        auto schema_itr = collection_schemas.find(schema_name.value);
+        vector <uint8_t> type_codes = get_schema_type_codes(*schema_itr);
+
+        ATTRIBUTE_MAP deserialized_immutable_data = deserialize(
+            immutable_serialized_data,
+            schema_itr->format,
+            type_codes
+        );
+        ATTRIBUTE_MAP deserialized_mutable_data = deserialize(
+            owner_asset.mutable_serialized_data,
+            schema_itr->format,
+            type_codes
+        );
+
+        action(
+            permission_level{get_self(), name("active")},
+            get_self(),
+            name("logburnasset"),
+            make_tuple(
+                asset_owner,
+                asset_id,
+                owner_asset.collection_name,
+                schema_name,
+                owner_asset.template_id,
+                owner_asset.backed_tokens,
+                deserialized_immutable_data,
+                deserialized_mutable_data,
+                owner_asset.ram_payer
+            )
+        ).send();
     }
 
+    if (owner_asset.immutable_blob_id.has_value()) {
+        internal_release_blob(owner_asset.collection_name, owner_asset.immutable_blob_id.value());
+    }
 
-    schemas_t collection_schemas = get_schemas(asset_itr->collection_name);
-    auto schema_itr = collection_schemas.find(asset_itr->schema_name.value);
+    if (owner_asset.template_id >= 0) {
+        internal_burn_template_supply(owner_asset.collection_name, owner_asset.template_id, 1);
+    }
 
-    ATTRIBUTE_MAP deserialized_immutable_data = deserialize(
-        asset_itr->immutable_serialized_data,
-        schema_itr->format
-    );
-    ATTRIBUTE_MAP deserialized_mutable_data = deserialize(
-        asset_itr->mutable_serialized_data,
-        schema_itr->format
-    );
+    internal_erase_asset(asset_owner, asset_id);
+}
+
+
+/**
+*  Burns (deletes) multiple assets of the same owner
+*  Template burnability is only looked up once per template, the tokens backed to all assets are added to the
+*  asset_owner's balance at once and a single logburnbatch action is sent for all assets
+*  @required_auth asset_owner
+*/
+ACTION atomicassets::burnassets(
+    name asset_owner,
+    vector <uint64_t> asset_ids
+) {
+    require_auth(asset_owner);
+
+    check(asset_ids.size() != 0, "asset_ids needs to contain at least one id");
+
+    vector <uint64_t> asset_ids_copy = asset_ids;
+    std::sort(asset_ids_copy.begin(), asset_ids_copy.end());
+    check(std::adjacent_find(asset_ids_copy.begin(), asset_ids_copy.end()) == asset_ids_copy.end(),
+        "Can't burn the same asset multiple times");
+
+    map <symbol, int64_t> backed_amounts = {};
+    map <pair <name, int32_t>, uint32_t> burned_template_amounts = {};
+
+    vector <BURNED_ASSET> burned_assets = {};
+    burned_assets.reserve(asset_ids.size());
+
+    for (uint64_t asset_id : asset_ids) {
+        assets_s owner_asset;
+        if (!find_asset(asset_owner, asset_id, owner_asset)) {
+            check(false, "No asset with this id exists for this owner (ID: " + to_string(asset_id) + ")");
+        }
+
+        if (!get_asset_flags(owner_asset).burnable) {
+            check(false, "At least one asset isn't burnable (ID: " + to_string(asset_id) + ")");
+        }
+
+        for (const asset &backed_quantity : owner_asset.backed_tokens) {
+            int64_t &total = backed_amounts[backed_quantity.symbol];
+            check(backed_quantity.amount <= asset::max_amount - total, "The backed tokens of the assets overflow");
+            total += backed_quantity.amount;
+        }
+
+        burned_assets.push_back({
+            asset_id,
+            owner_asset.collection_name,
+            get_asset_schema(owner_asset),
+            owner_asset.template_id,
+            owner_asset.backed_tokens,
+            get_immutable_data(owner_asset),
+            owner_asset.mutable_serialized_data,
+            owner_asset.ram_payer
+        });
+
+        if (owner_asset.immutable_blob_id.has_value()) {
+            internal_release_blob(owner_asset.collection_name, owner_asset.immutable_blob_id.value());
+        }
+
+        if (owner_asset.template_id >= 0) {
+            burned_template_amounts[{owner_asset.collection_name, owner_asset.template_id}]++;
+        }
+
+        internal_erase_asset(asset_owner, asset_id);
+    }
+
+    for (const auto &[template_key, amount] : burned_template_amounts) {
+        internal_burn_template_supply(template_key.first, template_key.second, amount);
+    }
+
+    if (backed_amounts.size() != 0) {
+        vector <asset> backed_tokens = {};
+        for (const auto &[backed_symbol, amount] : backed_amounts) {
+            backed_tokens.push_back(asset(amount, backed_symbol));
+        }
+        internal_increase_balance(asset_owner, backed_tokens);
+    }
 
     action(
         permission_level{get_self(), name("active")},
         get_self(),
-        name("logburnasset"),
-        make_tuple(
-            asset_owner,
-            asset_id,
-            asset_itr->collection_name,
-            asset_itr->schema_name,
-            asset_itr->template_id,
-            asset_itr->backed_tokens,
-            deserialized_immutable_data,
-            deserialized_mutable_data,
-            asset_itr->ram_payer
-        )
+        name("logburnbatch"),
+        make_tuple(asset_owner, burned_assets)
     ).send();
+}
+
+
+/**
+*  Moves assets of owner from the assets table into the globalassets table if FEATURE_GLOBAL_ASSETS is enabled,
+*  and otherwise into the compact and indexed assetsv2 table
+*  Up to max_assets assets with an id of at least lower_bound_id are looked at, so that callers can continue after
+*  assets that were skipped by a previous call. An asset keeps its ram_payer if they authorized the action or if the new
+*  row doesn't need more RAM than the old one. Otherwise, if owner authorized the action, owner becomes the ram_payer
+*  of the new row and the old ram_payer is refunded. Assets that fit none of these cases are skipped.
+*  @required_auth None, but without the authorization of owner or of the ram_payers, few assets can be migrated
+*/
+ACTION atomicassets::migassets(
+    name owner,
+    uint64_t lower_bound_id,
+    uint32_t max_assets
+) {
+    check(max_assets != 0, "max_assets needs to be at least 1");
+    bool global_assets = use_global_assets();
+    check(global_assets || use_compact_assets(), "Neither compact nor global asset rows are enabled");
+
+    assets_t owner_assets = get_assets(owner);
+    assetsv2_t owner_assetsv2 = get_assetsv2(owner);
+
+    auto asset_itr = owner_assets.lower_bound(lower_bound_id);
+    check(asset_itr != owner_assets.end(), "The owner doesn't have any assets left to migrate from lower_bound_id");
+
+    //The first row in a new scope also bills its ram_payer for the tables of the scope
+    bool scope_exists = global_assets
+                        ? globalassets.begin() != globalassets.end()
+                        : owner_assetsv2.begin() != owner_assetsv2.end();
+    uint64_t scope_ram = get_asset_scope_ram(!global_assets, global_assets);
+
+    uint32_t migrated = 0;
+    for (uint32_t looked_at = 0; looked_at < max_assets && asset_itr != owner_assets.end(); looked_at++) {
+        assets_s migrated_asset = *asset_itr;
+
+        uint64_t new_ram = global_assets
+                           ? get_asset_row_ram(pack_global_asset(owner, migrated_asset))
+                           : get_asset_row_ram(pack_asset(migrated_asset));
+        if (!scope_exists) {
+            new_ram += scope_ram;
+        }
+        if (!has_auth(migrated_asset.ram_payer) && new_ram > get_asset_row_ram(migrated_asset)) {
+            if (!has_auth(owner)) {
+                asset_itr++;
+                continue;
+            }
+            migrated_asset.ram_payer = owner;
+        }
 
-    owner_assets.erase(asset_itr);
+        if (global_assets) {
+            globalassets.emplace(migrated_asset.ram_payer, [&](auto &_asset) {
+                _asset = pack_global_asset(owner, migrated_asset);
+            });
+        } else {
+            owner_assetsv2.emplace(migrated_asset.ram_payer, [&](auto &_asset) {
+                _asset = pack_asset(migrated_asset);
+            });
+        }
+        scope_exists = true;
+        asset_itr = owner_assets.erase(asset_itr);
+        migrated++;
+    }
+    check(migrated != 0,
+        "None of the looked at assets can be migrated without the authorization of its ram_payer or of the owner");
 }
 
 
@@ -876,7 +1540,8 @@ ACTION atomicassets::createoffer(
     name recipient,
     vector <uint64_t> sender_asset_ids,
     vector <uint64_t> recipient_asset_ids,
-    string memo
+    string memo,
+    binary_extension <time_point_sec> expires_at
 ) {
     require_auth(sender);
 
@@ -889,6 +1554,10 @@ ACTION atomicassets::createoffer(
 
     check(memo.length() <= 256, "An offer memo can only be 256 characters max");
 
+    if (expires_at.has_value()) {
+        check(expires_at.value() > time_point_sec(current_time_point()), "The expiry must be in the future");
+    }
+
     vector <uint64_t> sender_ids_copy = sender_asset_ids;
     std::sort(sender_ids_copy.begin(), sender_ids_copy.end());
     check(std::adjacent_find(sender_ids_copy.begin(), sender_ids_copy.end()) == sender_ids_copy.end(),
@@ -899,37 +1568,29 @@ ACTION atomicassets::createoffer(
     check(std::adjacent_find(recipient_ids_copy.begin(), recipient_ids_copy.end()) == recipient_ids_copy.end(),
         "The assets in recipient_asset_ids must be unique");
 
-    assets_t sender_assets = get_assets(sender);
-    assets_t recipient_assets = get_assets(recipient);
-
+    assets_s offered_asset;
     for (uint64_t asset_id : sender_asset_ids) {
-        auto asset_itr = sender_assets.require_find(asset_id,
-            ("Offer sender doesn't own at least one of the provided assets (ID: " +
-             to_string(asset_id) + ")").c_str());
-        if (asset_itr->template_id >= 0) {
-            templates_t collection_templates = get_templates(asset_itr->collection_name);
-
-            auto template_itr = collection_templates.find(asset_itr->template_id);
-            check(template_itr->transferable,
-                ("At least one asset isn't transferable (ID: " + to_string(asset_id) + ")").c_str());
+        if (!find_asset(sender, asset_id, offered_asset)) {
+            check(false, "Offer sender doesn't own at least one of the provided assets (ID: " +
+                         to_string(asset_id) + ")");
+        }
+        if (!get_asset_flags(offered_asset).transferable) {
+            check(false, "At least one asset isn't transferable (ID: " + to_string(asset_id) + ")");
         }
     }
     for (uint64_t asset_id : recipient_asset_ids) {
-        auto asset_itr = recipient_assets.require_find(asset_id,
-            ("Offer recipient doesn't own at least one of the provided assets (ID: " +
-             to_string(asset_id) + ")").c_str());
-        if (asset_itr->template_id >= 0) {
-            templates_t collection_templates = get_templates(asset_itr->collection_name);
-
-            auto template_itr = collection_templates.find(asset_itr->template_id);
-            check(template_itr->transferable,
-                ("At least one asset isn't transferable (ID: " + to_string(asset_id) + ")").c_str());
+        if (!find_asset(recipient, asset_id, offered_asset)) {
+            check(false, "Offer recipient doesn't own at least one of the provided assets (ID: " +
+                         to_string(asset_id) + ")");
+        }
+        if (!get_asset_flags(offered_asset).transferable) {
+            check(false, "At least one asset isn't transferable (ID: " + to_string(asset_id) + ")");
         }
     }
 
-    config_s current_config = config.get();
-    uint64_t offer_id = current_config.offer_counter++;
-    offers.emplace(sender, [&](auto &_offer) {
+    counters_s current_counters = get_counters();
+    uint64_t offer_id = current_counters.offer_counter++;
+    auto offer_itr = offers.emplace(sender, [&](auto &_offer) {
         _offer.offer_id = offer_id;
         _offer.sender = sender;
         _offer.recipient = recipient;
@@ -937,15 +1598,18 @@ ACTION atomicassets::createoffer(
         _offer.recipient_asset_ids = recipient_asset_ids;
         _offer.memo = memo;
         _offer.ram_payer = sender;
+        _offer.expires_at = expires_at;
     });
 
-    config.set(current_config, get_self());
+    internal_index_offer(*offer_itr);
+
+    counters.set(current_counters, get_self());
 
     action(
         permission_level{get_self(), name("active")},
         get_self(),
         name("lognewoffer"),
-        make_tuple(offer_id, sender, recipient, sender_asset_ids, recipient_asset_ids, memo)
+        make_tuple(offer_id, sender, recipient, sender_asset_ids, recipient_asset_ids, memo, expires_at)
     ).send();
 }
 
@@ -962,7 +1626,7 @@ ACTION atomicassets::canceloffer(
 
     require_auth(offer_itr->sender);
 
-    offers.erase(offer_itr);
+    internal_erase_offer(*offer_itr);
 }
 
 
@@ -980,44 +1644,44 @@ ACTION atomicassets::acceptoffer(
 
     require_auth(offer_itr->recipient);
 
+    check(offer_itr->by_expiry() > current_time_point().sec_since_epoch(), "The offer has expired");
+
     require_recipient(offer_itr->sender);
     require_recipient(offer_itr->recipient);
 
-    assets_t sender_assets = get_assets(offer_itr->sender);
-    assets_t recipient_assets = get_assets(offer_itr->recipient);
-    for (uint64_t asset_id : offer_itr->sender_asset_ids) {
-        sender_assets.require_find(asset_id,
-            ("Offer sender doesn't own at least one of the provided assets (ID: " +
-             to_string(asset_id) + ")").c_str());
-    }
-    for (uint64_t asset_id : offer_itr->recipient_asset_ids) {
-        recipient_assets.require_find(asset_id,
-            ("Offer recipient doesn't own at least one of the provided assets (ID: " +
-             to_string(asset_id) + ")").c_str());
-    }
+    //Other offers that contain the assets are not erased here, see gcoffers
+    offers_s offer = *offer_itr;
+    internal_erase_offer(*offer_itr);
+
+    //createoffer already checked that the accounts are distinct, that the asset ids are unique and that all assets
+    //are transferable (which can't change), so the assets only have to be looked up once while moving them,
+    //which throws if one of the sides doesn't own one of its assets anymore
+    string memo = "Accepted Offer ID: " + to_string(offer_id);
 
-    if (offer_itr->recipient_asset_ids.size() != 0) {
+    if (offer.recipient_asset_ids.size() != 0) {
         //Potential scope costs for offer sender are offset by removing the entry from the offer table
-        internal_transfer(
-            offer_itr->recipient,
-            offer_itr->sender,
-            offer_itr->recipient_asset_ids,
-            string("Accepted Offer ID: " + to_string(offer_id)),
-            offer_itr->ram_payer
+        internal_send_assets(
+            offer.recipient,
+            offer.sender,
+            offer.recipient_asset_ids,
+            memo,
+            offer.ram_payer,
+            "Offer recipient",
+            false
         );
     }
 
-    if (offer_itr->sender_asset_ids.size() != 0) {
-        internal_transfer(
-            offer_itr->sender,
-            offer_itr->recipient,
-            offer_itr->sender_asset_ids,
-            string("Accepted Offer ID: " + to_string(offer_id)),
-            offer_itr->recipient
+    if (offer.sender_asset_ids.size() != 0) {
+        internal_send_assets(
+            offer.sender,
+            offer.recipient,
+            offer.sender_asset_ids,
+            memo,
+            offer.recipient,
+            "Offer sender",
+            false
         );
     }
-
-    offers.erase(offer_itr);
 }
 
 
@@ -1034,7 +1698,56 @@ ACTION atomicassets::declineoffer(
 
     require_auth(offer_itr->recipient);
 
-    offers.erase(offer_itr);
+    internal_erase_offer(*offer_itr);
+}
+
+
+/**
+*  Erases up to max_offers offers that can't be accepted anymore
+*  First, the offers in offer_ids are erased if they have expired or if their sender or recipient no longer owns
+*  all of their assets. The ids of offers that contain an asset can be found in its assetoffers scope.
+*  Offers in offer_ids that don't exist or can still be accepted are skipped.
+*  Then expired offers are erased, starting with the ones that expired first.
+*  The RAM of the erased offers is refunded to their ram_payer
+*  @required_auth None
+*/
+ACTION atomicassets::gcoffers(
+    uint32_t max_offers,
+    binary_extension <vector <uint64_t>> offer_ids
+) {
+    check(max_offers != 0, "max_offers needs to be at least 1");
+
+    uint32_t erased_offers = 0;
+
+    //Offers created before the expiry index existed can only be erased this way
+    if (offer_ids.has_value()) {
+        for (uint64_t offer_id : offer_ids.value()) {
+            if (erased_offers == max_offers) {
+                break;
+            }
+            auto offer_itr = offers.find(offer_id);
+            if (offer_itr == offers.end() || is_offer_acceptable(*offer_itr)) {
+                continue;
+            }
+            internal_erase_offer(*offer_itr);
+            erased_offers++;
+        }
+    }
+
+    uint64_t now = current_time_point().sec_since_epoch();
+
+    auto offers_by_expiry = offers.get_index <name("expiry")>();
+
+    while (erased_offers < max_offers) {
+        auto offer_itr = offers_by_expiry.begin();
+        if (offer_itr == offers_by_expiry.end() || offer_itr->by_expiry() > now) {
+            break;
+        }
+        internal_erase_offer(*offer_itr);
+        erased_offers++;
+    }
+
+    check(erased_offers != 0, "There are no expired or invalid offers");
 }
 
 
@@ -1061,6 +1774,16 @@ ACTION atomicassets::payofferram(
         _offer = offer_copy;
         _offer.ram_payer = payer;
     });
+
+    for (const vector <uint64_t> *asset_ids : {&offer_copy.sender_asset_ids, &offer_copy.recipient_asset_ids}) {
+        for (uint64_t asset_id : *asset_ids) {
+            assetoffers_t asset_offers = get_asset_offers(asset_id);
+            auto asset_offer_itr = asset_offers.find(offer_id);
+            if (asset_offer_itr != asset_offers.end()) {
+                asset_offers.modify(asset_offer_itr, payer, [&](auto &_asset_offer) {});
+            }
+        }
+    }
 }
 
 
@@ -1073,19 +1796,27 @@ void atomicassets::receive_token_transfer(name from, name to, asset quantity, st
         return;
     }
 
-    config_s current_config = config.get();
+    //A single lookup, so that transfers of unsupported tokens fail as early as possible
+    auto suptoken_itr = suptokens.find(quantity.symbol.code().raw());
+    check(suptoken_itr != suptokens.end()
+          && suptoken_itr->token.get_contract() == get_first_receiver()
+          && suptoken_itr->token.get_symbol() == quantity.symbol,
+        "The transferred token is not supported");
 
-    bool is_supported = false;
-    for (extended_symbol token : current_config.supported_tokens) {
-        if (token.get_contract() == get_first_receiver() && token.get_symbol() == quantity.symbol) {
-            is_supported = true;
+    if (memo == "deposit") {
+        //The balance row's RAM can't be billed to from in a notification, so the row must already exist
+        symbalances_t from_balances = get_symbol_balances(from);
+        auto symbol_balance_itr = from_balances.find(quantity.symbol.code().raw());
+        if (symbol_balance_itr != from_balances.end() && symbol_balance_itr->quantity.symbol == quantity.symbol) {
+            from_balances.modify(symbol_balance_itr, same_payer, [&](auto &_balance) {
+                _balance.quantity.amount += quantity.amount;
+            });
+            return;
         }
-    }
-    check(is_supported, "The transferred token is not supported");
 
-    if (memo == "deposit") {
+        //Balances that have not been moved to the symbalances table yet
         auto balance_itr = balances.require_find(from.value,
-            "You need to first initialize the balance table row using the announcedepo action");
+            "You first need to announce the asset type you're backing using the announcedepo action");
 
         //Quantities refers to the quantities value in the balances table row, quantity is the asset that was transferred
         vector <asset> quantities = balance_itr->quantities;
@@ -1118,7 +1849,32 @@ ACTION atomicassets::logtransfer(
 ) {
     require_auth(get_self());
 
-    notify_collection_accounts(collection_name);
+    notify_collection_accounts(collection_name, NOTIFY_TRANSFER);
+}
+
+
+ACTION atomicassets::logtransfers(
+    name collection_name,
+    name from,
+    vector <TRANSFER_GROUP> transfers
+) {
+    require_auth(get_self());
+
+    notify_collection_accounts(collection_name, NOTIFY_TRANSFER);
+}
+
+
+ACTION atomicassets::logtransfer2(
+    name from,
+    name to,
+    vector <COLLECTION_ASSETS> collection_assets,
+    string memo
+) {
+    require_auth(get_self());
+
+    for (const COLLECTION_ASSETS &assets_of_collection : collection_assets) {
+        notify_collection_accounts(assets_of_collection.collection_name, NOTIFY_TRANSFER);
+    }
 }
 
 
@@ -1128,7 +1884,8 @@ ACTION atomicassets::lognewoffer(
     name recipient,
     vector <uint64_t> sender_asset_ids,
     vector <uint64_t> recipient_asset_ids,
-    string memo
+    string memo,
+    binary_extension <time_point_sec> expires_at
 ) {
     require_auth(get_self());
 
@@ -1149,7 +1906,7 @@ ACTION atomicassets::lognewtempl(
 ) {
     require_auth(get_self());
 
-    notify_collection_accounts(collection_name);
+    notify_collection_accounts(collection_name, NOTIFY_TEMPLATE);
 }
 
 
@@ -1169,7 +1926,26 @@ ACTION atomicassets::logmint(
 
     require_recipient(new_asset_owner);
 
-    notify_collection_accounts(collection_name);
+    notify_collection_accounts(collection_name, NOTIFY_MINT);
+}
+
+
+ACTION atomicassets::logmintraw(
+    uint64_t asset_id,
+    name authorized_minter,
+    name collection_name,
+    name schema_name,
+    int32_t template_id,
+    name new_asset_owner,
+    vector <uint8_t> immutable_serialized_data,
+    vector <uint8_t> mutable_serialized_data,
+    vector <asset> backed_tokens
+) {
+    require_auth(get_self());
+
+    require_recipient(new_asset_owner);
+
+    notify_collection_accounts(collection_name, NOTIFY_MINT);
 }
 
 
@@ -1181,10 +1957,24 @@ ACTION atomicassets::logsetdata(
 ) {
     require_auth(get_self());
 
-    assets_t owner_assets = get_assets(asset_owner);
-    auto asset_itr = owner_assets.find(asset_id);
+    assets_s owner_asset;
+    find_asset(asset_owner, asset_id, owner_asset);
+
+    notify_collection_accounts(owner_asset.collection_name, NOTIFY_SETDATA);
+}
+
+
+ACTION atomicassets::logsetraw(
+    name asset_owner,
+    uint64_t asset_id,
+    name collection_name,
+    name schema_name,
+    vector <uint8_t> old_serialized_data,
+    vector <uint8_t> new_serialized_data
+) {
+    require_auth(get_self());
 
-    notify_collection_accounts(asset_itr->collection_name);
+    notify_collection_accounts(collection_name, NOTIFY_SETDATA);
 }
 
 
@@ -1197,10 +1987,10 @@ ACTION atomicassets::logbackasset(
 
     require_recipient(asset_owner);
 
-    assets_t owner_assets = get_assets(asset_owner);
-    auto asset_itr = owner_assets.find(asset_id);
+    assets_s owner_asset;
+    find_asset(asset_owner, asset_id, owner_asset);
 
-    notify_collection_accounts(asset_itr->collection_name);
+    notify_collection_accounts(owner_asset.collection_name, NOTIFY_BACK);
 }
 
 
@@ -1217,7 +2007,65 @@ ACTION atomicassets::logburnasset(
 ) {
     require_auth(get_self());
 
-    notify_collection_accounts(collection_name);
+    notify_collection_accounts(collection_name, NOTIFY_BURN);
+}
+
+
+ACTION atomicassets::logburnraw(
+    name asset_owner,
+    uint64_t asset_id,
+    name collection_name,
+    name schema_name,
+    int32_t template_id,
+    vector <asset> backed_tokens,
+    vector <uint8_t> old_immutable_serialized_data,
+    vector <uint8_t> old_mutable_serialized_data,
+    name asset_ram_payer
+) {
+    require_auth(get_self());
+
+    notify_collection_accounts(collection_name, NOTIFY_BURN);
+}
+
+
+ACTION atomicassets::logbackbatch(
+    name payer,
+    name asset_owner,
+    vector <BACKED_ASSET> backed_assets
+) {
+    require_auth(get_self());
+
+    require_recipient(asset_owner);
+
+    set <name> collections_notified = {};
+    for (const BACKED_ASSET &backed_asset : backed_assets) {
+        if (collections_notified.insert(backed_asset.collection_name).second) {
+            notify_collection_accounts(backed_asset.collection_name, NOTIFY_BACK);
+        }
+    }
+}
+
+
+ACTION atomicassets::logburnbatch(
+    name asset_owner,
+    vector <BURNED_ASSET> burned_assets
+) {
+    require_auth(get_self());
+
+    set <name> collections_notified = {};
+    for (const BURNED_ASSET &burned_asset : burned_assets) {
+        if (collections_notified.insert(burned_asset.collection_name).second) {
+            notify_collection_accounts(burned_asset.collection_name, NOTIFY_BURN);
+        }
+    }
+}
+
+
+ACTION atomicassets::logskiptoken(
+    extended_symbol skipped_token,
+    extended_symbol supported_token
+) {
+    require_auth(get_self());
 }
 
 
@@ -1249,70 +2097,49 @@ void atomicassets::internal_transfer(
     check(std::adjacent_find(asset_ids_copy.begin(), asset_ids_copy.end()) == asset_ids_copy.end(),
         "Can't transfer the same asset multiple times");
 
-    assets_t from_assets = get_assets(from);
-    assets_t to_assets = get_assets(to);
-
-    map <name, vector <uint64_t>> collection_to_assets_transferred = {};
-
-    for (uint64_t asset_id : asset_ids) {
-        auto asset_itr = from_assets.require_find(asset_id,
-            ("Sender doesn't own at least one of the provided assets (ID: " +
-             to_string(asset_id) + ")").c_str());
+    internal_send_assets(from, to, asset_ids, memo, scope_payer, "Sender", true);
+}
 
-        //Existence doesn't have to be checked because this always has to exist
-        if (asset_itr->template_id >= 0) {
-            templates_t collection_templates = get_templates(asset_itr->collection_name);
 
-            auto template_itr = collection_templates.find(asset_itr->template_id);
-            check(template_itr->transferable,
-                ("At least one asset isn't transferable (ID: " + to_string(asset_id) + ")").c_str());
-        }
+/**
+*  Moves the assets and sends the transfer logs, without validating the transfer itself
+*  The caller has to make sure that to exists, that from != to and that the asset ids are unique
+*/
+void atomicassets::internal_send_assets(
+    name from,
+    name to,
+    const vector <uint64_t> &asset_ids,
+    const string &memo,
+    name scope_payer,
+    const char *from_description,
+    bool check_transferable
+) {
+    map <name, vector <uint64_t>> collection_to_assets_transferred = internal_move_assets(
+        from,
+        to,
+        asset_ids,
+        scope_payer,
+        from_description,
+        check_transferable
+    );
 
-        //This is needed for sending notifications later
-        if (collection_to_assets_transferred.find(asset_itr->collection_name) !=
-            collection_to_assets_transferred.end()) {
-            collection_to_assets_transferred[asset_itr->collection_name].push_back(asset_id);
-        } else {
-            collection_to_assets_transferred[asset_itr->collection_name] = {asset_id};
-        }
-
-        //to assets are empty => no scope has been created yet
-        bool no_previous_scope = to_assets.begin() == to_assets.end();
-        if (no_previous_scope) {
-            //A dummy asset is emplaced, which makes the scope_payer pay for the ram of the scope
-            //This asset is later deleted again.
-            //This action will therefore fail is the scope_payer didn't authorize the action
-            to_assets.emplace(scope_payer, [&](auto &_asset) {
-                _asset.asset_id = ULLONG_MAX;
-                _asset.collection_name = name("");
-                _asset.schema_name = name("");
-                _asset.template_id = -1;
-                _asset.ram_payer = scope_payer;
-                _asset.backed_tokens = {};
-                _asset.immutable_serialized_data = {};
-                _asset.mutable_serialized_data = {};
-            });
+    //Sending notifications
+    if (is_feature_enabled(FEATURE_COMBINED_TRANSFER_LOG)) {
+        vector <COLLECTION_ASSETS> collection_assets = {};
+        collection_assets.reserve(collection_to_assets_transferred.size());
+        for (auto &[collection, assets_transferred] : collection_to_assets_transferred) {
+            collection_assets.push_back({collection, std::move(assets_transferred)});
         }
 
-        to_assets.emplace(asset_itr->ram_payer, [&](auto &_asset) {
-            _asset.asset_id = asset_itr->asset_id;
-            _asset.collection_name = asset_itr->collection_name;
-            _asset.schema_name = asset_itr->schema_name;
-            _asset.template_id = asset_itr->template_id;
-            _asset.ram_payer = asset_itr->ram_payer;
-            _asset.backed_tokens = asset_itr->backed_tokens;
-            _asset.immutable_serialized_data = asset_itr->immutable_serialized_data;
-            _asset.mutable_serialized_data = asset_itr->mutable_serialized_data;
-        });
-
-        from_assets.erase(asset_itr);
-
-        if (no_previous_scope) {
-            to_assets.erase(to_assets.find(ULLONG_MAX));
-        }
+        action(
+            permission_level{get_self(), name("active")},
+            get_self(),
+            name("logtransfer2"),
+            make_tuple(from, to, collection_assets, memo)
+        ).send();
+        return;
     }
 
-    //Sending notifications
     for (const auto&[collection, assets_transferred] : collection_to_assets_transferred) {
         action(
             permission_level{get_self(), name("active")},
@@ -1325,121 +2152,965 @@ void atomicassets::internal_transfer(
 
 
 /**
-*  The specified asset is backed by the specified quantitiy.
-*  This is done in an internal function because it is needed both in the mintasset and the backasset action
+*  Mints one or more assets of the same collection, schema and template
+*  The template's supply counter and the asset counter are only updated once for all assets,
+*  and the template data needed for the logs is only deserialized once.
+*  This is done in an internal function because it is needed both in the mintasset and the mintassets action
 */
-void atomicassets::internal_back_asset(
-    name payer,
-    name asset_owner,
-    uint64_t asset_id,
-    asset token_to_back
+void atomicassets::internal_mint_assets(
+    name authorized_minter,
+    name collection_name,
+    name schema_name,
+    int32_t template_id,
+    const vector <MINT_DATA> &assets_to_mint,
+    bool from_reserved_supply
 ) {
-    check(token_to_back.amount > 0, "token_to_back must be positive");
+    check_has_collection_auth(
+        authorized_minter,
+        collection_name,
+        "The minter is not authorized within the collection"
+    );
 
-    //The internal_decrease_balance function will throw if payer does not have a sufficient balance
-    internal_decrease_balance(payer, token_to_back);
+    schemas_t collection_schemas = get_schemas(collection_name);
+    auto schema_itr = collection_schemas.require_find(schema_name.value,
+        "No schema with this name exists");
+    vector <uint8_t> type_codes = get_schema_type_codes(*schema_itr);
 
-    assets_t owner_assets = get_assets(asset_owner);
-    auto asset_itr = owner_assets.require_find(asset_id,
-        "The specified owner does not own the asset with the specified ID");
+    //Raw data logs reference the template by its id instead of including its data
+    bool raw_data_logs = is_feature_enabled(FEATURE_RAW_DATA_LOGS);
+
+    //Needed for the log action
+    ATTRIBUTE_MAP deserialized_template_data;
+    //Assets without a template are always transferable and burnable
+    uint8_t asset_flags = ASSET_FLAG_TRANSFERABLE | ASSET_FLAG_BURNABLE;
+    if (template_id >= 0) {
+        templates_t collection_templates = get_templates(collection_name);
 
-    if (asset_itr->template_id != -1) {
-        templates_t collection_templates = get_templates(asset_itr->collection_name);
+        auto template_itr = collection_templates.require_find(template_id,
+            "No template with this id exists");
 
-        auto template_itr = collection_templates.find(asset_itr->template_id);
-        check(template_itr->burnable, "The asset is not burnable. Only burnable assets can be backed.");
-    }
+        check(template_itr->schema_name == schema_name,
+            "The template belongs to another schema");
 
-    vector <asset> backed_tokens = asset_itr->backed_tokens;
-    bool found_backed_token = false;
-    for (asset &token : backed_tokens) {
-        if (token.symbol == token_to_back.symbol) {
-            found_backed_token = true;
-            token.amount += token_to_back.amount;
-            break;
+        internal_issue_template_supply(
+            collection_name,
+            *template_itr,
+            assets_to_mint.size(),
+            authorized_minter,
+            from_reserved_supply
+        );
+
+        asset_flags = (template_itr->transferable ? ASSET_FLAG_TRANSFERABLE : 0)
+                      | (template_itr->burnable ? ASSET_FLAG_BURNABLE : 0);
+
+        if (!raw_data_logs) {
+            deserialized_template_data = deserialize(
+                get_immutable_data(collection_name, *template_itr),
+                schema_itr->format,
+                type_codes
+            );
         }
+    } else {
+        check(template_id == -1, "The template id must either be an existing template or -1");
+
+        deserialized_template_data = {};
     }
-    if (!found_backed_token) {
-        backed_tokens.push_back(token_to_back);
+
+    set <name> checked_owners = {};
+    for (const MINT_DATA &mint_data : assets_to_mint) {
+        if (checked_owners.find(mint_data.new_asset_owner) == checked_owners.end()) {
+            check(is_account(mint_data.new_asset_owner), "The new_asset_owner account does not exist");
+            checked_owners.insert(mint_data.new_asset_owner);
+        }
+
+        check_name_length(mint_data.immutable_data);
+        check_name_length(mint_data.mutable_data);
     }
 
-    owner_assets.modify(asset_itr, payer, [&](auto &_asset) {
-        _asset.ram_payer = payer;
-        _asset.backed_tokens = backed_tokens;
-    });
+    counters_s current_counters = get_counters();
+    uint64_t asset_id = current_counters.asset_counter;
+    current_counters.asset_counter += assets_to_mint.size();
+    counters.set(current_counters, get_self());
 
-    action(
-        permission_level{get_self(), name("active")},
-        get_self(),
-        name("logbackasset"),
-        make_tuple(asset_owner, asset_id, token_to_back)
-    ).send();
-}
+    bool store_asset_flags = is_feature_enabled(FEATURE_ASSET_FLAGS);
+    bool shared_blobs = is_feature_enabled(FEATURE_SHARED_BLOBS);
 
+    for (const MINT_DATA &mint_data : assets_to_mint) {
+        vector <uint8_t> immutable_serialized_data = serialize(
+            mint_data.immutable_data,
+            schema_itr->format,
+            type_codes
+        );
+        uint64_t immutable_blob_id;
+        bool use_blob = shared_blobs
+                        && internal_store_blob(collection_name, immutable_serialized_data, authorized_minter, immutable_blob_id);
+
+        assets_s new_asset = {};
+        new_asset.asset_id = asset_id;
+        new_asset.collection_name = collection_name;
+        new_asset.schema_name = schema_name;
+        new_asset.template_id = template_id;
+        new_asset.ram_payer = authorized_minter;
+        new_asset.backed_tokens = {};
+        new_asset.immutable_serialized_data = use_blob ? vector <uint8_t>{} : immutable_serialized_data;
+        new_asset.mutable_serialized_data = serialize(mint_data.mutable_data, schema_itr->format, type_codes);
+        //The flags are stored before the blob id in the row, so they have to be set as well
+        if (store_asset_flags || use_blob) {
+            new_asset.flags.emplace(asset_flags);
+        }
+        if (use_blob) {
+            new_asset.immutable_blob_id.emplace(immutable_blob_id);
+        }
+        internal_store_asset(mint_data.new_asset_owner, new_asset);
 
-/**
-*  Decreases the balance of a specified account by a specified quantity
-*  If the specified account does not have at least as much tokens in the balance as should be removed
-*  the transaction will fail
-*/
-void atomicassets::internal_decrease_balance(
-    name owner,
-    asset quantity
-) {
-    auto balance_itr = balances.require_find(owner.value,
-        "The specified account does not have a balance table row");
 
-    vector <asset> quantities = balance_itr->quantities;
-    bool found_token = false;
-    for (auto itr = quantities.begin(); itr != quantities.end(); itr++) {
-        if (itr->symbol == quantity.symbol) {
-            found_token = true;
-            check(itr->amount >= quantity.amount,
-                "The specified account's balance is lower than the specified quantity");
-            itr->amount -= quantity.amount;
-            if (itr->amount == 0) {
-                quantities.erase(itr);
-            }
-            break;
+        if (raw_data_logs) {
+            action(
+                permission_level{get_self(), name("active")},
+                get_self(),
+                name("logmintraw"),
+                make_tuple(
+                    asset_id,
+                    authorized_minter,
+                    collection_name,
+                    schema_name,
+                    template_id,
+                    mint_data.new_asset_owner,
+                    immutable_serialized_data,
+                    new_asset.mutable_serialized_data,
+                    mint_data.tokens_to_back
+                )
+            ).send();
+        } else {
+            action(
+                permission_level{get_self(), name("active")},
+                get_self(),
+                name("logmint"),
+                make_tuple(
+                    asset_id,
+                    authorized_minter,
+                    collection_name,
+                    schema_name,
+                    template_id,
+                    mint_data.new_asset_owner,
+                    mint_data.immutable_data,
+                    mint_data.mutable_data,
+                    mint_data.tokens_to_back,
+                    deserialized_template_data
+                )
+            ).send();
         }
-    }
-    check(found_token,
-        "The specified account does not have a balance for the symbol specified in the quantity");
 
-    //Updating the balances table
-    if (quantities.size() > 0) {
-        balances.modify(balance_itr, same_payer, [&](auto &_balance) {
-            _balance.quantities = quantities;
-        });
-    } else {
-        balances.erase(balance_itr);
+        //Calls the internal_back_asset function which handles asset backing.
+        //It will throw if authorized_minter does not have a sufficient balance to pay for the backed tokens
+        //Token validity must not be cross-checked with config.supported_tokens because it's implicitly checked
+        //when decreasing minter's balance (only supported tokens can be deposited)
+        set <symbol> used_symbols = {};
+        for (const asset &token : mint_data.tokens_to_back) {
+            check(used_symbols.find(token.symbol) == used_symbols.end(),
+                "Symbols in the tokens_to_back must be unique");
+            used_symbols.emplace(token.symbol);
+            internal_back_asset(authorized_minter, mint_data.new_asset_owner, asset_id, token);
+        }
+
+        asset_id++;
     }
 }
 
 
 /**
-* Notifies all of a collection's notify accounts using require_recipient
+*  Appends recipients to an airdrop, split into chunks of at most AIRDROP_CHUNK_SIZE recipients
+*  Each chunk holds a RAM reserve for the assets that will be minted to its recipients, paid by authorized_minter
 */
-void atomicassets::notify_collection_accounts(
-    name collection_name
+void atomicassets::internal_add_airdrop_recipients(
+    uint64_t airdrop_id,
+    name authorized_minter,
+    const vector <name> &recipients
+) {
+    check(recipients.size() != 0, "Need to add at least one recipient");
+
+    auto airdrop_itr = airdrops.find(airdrop_id);
+
+    //The supply is reserved across all open airdrops and mints, so that every airdrop can be completed
+    templates_t collection_templates = get_templates(airdrop_itr->collection_name);
+    auto template_itr = collection_templates.find(airdrop_itr->template_id);
+    internal_reserve_template_supply(airdrop_itr->collection_name, *template_itr, recipients.size());
+
+    set <name> checked_recipients = {};
+    for (const name &recipient : recipients) {
+        if (checked_recipients.find(recipient) == checked_recipients.end()) {
+            check(is_account(recipient), "At least one recipient does not exist - " + recipient.to_string());
+            checked_recipients.insert(recipient);
+        }
+    }
+
+    uint64_t ram_per_recipient = get_airdrop_recipient_ram();
+
+    dropchunks_t airdrop_chunks = get_airdrop_chunks(airdrop_id);
+    for (uint64_t offset = 0; offset < recipients.size(); offset += AIRDROP_CHUNK_SIZE) {
+        uint64_t chunk_size = std::min(AIRDROP_CHUNK_SIZE, recipients.size() - offset);
+
+        airdrop_chunks.emplace(authorized_minter, [&](auto &_chunk) {
+            _chunk.chunk_id = airdrop_chunks.available_primary_key();
+            _chunk.recipients = vector <name>(
+                recipients.begin() + offset,
+                recipients.begin() + offset + chunk_size
+            );
+            _chunk.ram_reserve = vector <uint8_t>(chunk_size * ram_per_recipient, 0);
+        });
+    }
+
+    airdrops.modify(airdrop_itr, same_payer, [&](auto &_airdrop) {
+        _airdrop.assets_remaining += recipients.size();
+    });
+}
+
+
+/**
+*  The RAM that is billed for an asset minted by an airdrop, depending on the table that the asset is stored in
+*  Airdropped assets don't have any data of their own, so this is the same for all of them
+*/
+uint64_t atomicassets::get_airdrop_asset_ram(bool compact_assets, bool global_assets) {
+    //The flags byte is always included, so that enabling FEATURE_ASSET_FLAGS can't make existing reserves too small
+    assets_s airdropped_asset = {};
+    airdropped_asset.flags.emplace(0);
+    //Assets without a template have the longest packed data, because it includes the schema_name
+    airdropped_asset.template_id = -1;
+
+    if (global_assets) {
+        return get_asset_row_ram(pack_global_asset(name(), airdropped_asset));
+    }
+    if (compact_assets) {
+        return get_asset_row_ram(pack_asset(airdropped_asset));
+    }
+    return get_asset_row_ram(airdropped_asset);
+}
+
+
+/**
+*  The RAM that is billed for an asset row, including the secondary index entries of its table
+*/
+uint64_t atomicassets::get_asset_row_ram(const assets_s &asset_row) {
+    return pack_size(asset_row) + RAM_ROW_OVERHEAD;
+}
+
+uint64_t atomicassets::get_asset_row_ram(const assetsv2_s &asset_row) {
+    return pack_size(asset_row) + RAM_ROW_OVERHEAD + RAM_INDEX128_OVERHEAD;
+}
+
+uint64_t atomicassets::get_asset_row_ram(const globalassets_s &asset_row) {
+    return pack_size(asset_row) + RAM_ROW_OVERHEAD + RAM_INDEX256_OVERHEAD;
+}
+
+
+/**
+*  The RAM that is billed for the first asset in a new scope of the table that assets are stored in,
+*  for the table of the rows and the table of each secondary index
+*/
+uint64_t atomicassets::get_asset_scope_ram(bool compact_assets, bool global_assets) {
+    if (global_assets) {
+        return RAM_SCOPE_OVERHEAD * (1 + GLOBALASSETS_INDEX_COUNT);
+    }
+    if (compact_assets) {
+        return RAM_SCOPE_OVERHEAD * (1 + ASSETSV2_INDEX_COUNT);
+    }
+    return RAM_SCOPE_OVERHEAD * (1 + ASSETS_INDEX_COUNT);
+}
+
+
+/**
+*  The RAM that is reserved for each recipient of an airdrop: enough for the asset and a new scope
+*  The largest layout is reserved, so that changing the asset storage features can't make the reserve too small
+*/
+uint64_t atomicassets::get_airdrop_recipient_ram() {
+    return std::max({
+        get_airdrop_asset_ram(false, false) + get_asset_scope_ram(false, false),
+        get_airdrop_asset_ram(true, false) + get_asset_scope_ram(true, false),
+        get_airdrop_asset_ram(false, true) + get_asset_scope_ram(false, true)
+    });
+}
+
+
+/**
+*  Lists the offer in the assetoffers table of each of its assets
+*/
+void atomicassets::internal_index_offer(const offers_s &offer) {
+    for (const vector <uint64_t> *asset_ids : {&offer.sender_asset_ids, &offer.recipient_asset_ids}) {
+        for (uint64_t asset_id : *asset_ids) {
+            get_asset_offers(asset_id).emplace(offer.ram_payer, [&](auto &_asset_offer) {
+                _asset_offer.offer_id = offer.offer_id;
+            });
+        }
+    }
+}
+
+
+/**
+*  Erases an offer together with its assetoffers entries
+*/
+void atomicassets::internal_erase_offer(const offers_s &offer) {
+    for (const vector <uint64_t> *asset_ids : {&offer.sender_asset_ids, &offer.recipient_asset_ids}) {
+        for (uint64_t asset_id : *asset_ids) {
+            assetoffers_t asset_offers = get_asset_offers(asset_id);
+            auto asset_offer_itr = asset_offers.find(offer.offer_id);
+            //Offers created before the assetoffers table existed have no entries
+            if (asset_offer_itr != asset_offers.end()) {
+                asset_offers.erase(asset_offer_itr);
+            }
+        }
+    }
+
+    offers.erase(offer);
+}
+
+
+/**
+*  Moves the specified assets from the scope of the from account into the scope of the to account
+*  Throws if any of the assets does not exist in the from scope or, if check_transferable is set, is not transferable.
+*  from_description names the from account in error messages
+*
+*  Assets in the globalassets table only get a new owner. Other assets are moved into the globalassets table if
+*  FEATURE_GLOBAL_ASSETS is enabled and either their ram_payer authorized the action or the new row doesn't need more
+*  RAM, because the ram_payer's RAM can't increase otherwise. If not, assets in the assetsv2 table stay in it, and
+*  assets in the assets table are moved into the assetsv2 table under the same condition with FEATURE_COMPACT_ASSETS.
+*  Returns the ids of the moved assets grouped by collection, which is needed for sending notifications
+*/
+map <name, vector <uint64_t>> atomicassets::internal_move_assets(
+    name from,
+    name to,
+    const vector <uint64_t> &asset_ids,
+    name scope_payer,
+    const char *from_description,
+    bool check_transferable
+) {
+    bool global_assets = use_global_assets();
+    bool compact_assets = use_compact_assets();
+
+    assets_t &from_assets = get_cached_assets(from);
+    assetsv2_t &from_assetsv2 = get_cached_assetsv2(from);
+    assets_t &to_assets = get_cached_assets(to);
+    assetsv2_t &to_assetsv2 = get_cached_assetsv2(to);
+
+    //If to doesn't have a scope in a table yet, a dummy asset is emplaced before the first asset is moved into it,
+    //which makes the scope_payer pay for the ram of the scope. The dummy asset is later deleted again.
+    //This action will therefore fail is the scope_payer didn't authorize the action
+    bool checked_scope = false;
+    bool checked_scopev2 = false;
+    bool added_dummy = false;
+    bool added_dummyv2 = false;
+
+    map <name, vector <uint64_t>> collection_to_assets_transferred = {};
+    bool global_used = global_assets_used();
+
+    for (uint64_t asset_id : asset_ids) {
+        auto global_itr = global_used ? globalassets.find(asset_id) : globalassets.end();
+        if (global_itr != globalassets.end()) {
+            if (global_itr->owner != from) {
+                check(false, string(from_description) + " doesn't own at least one of the provided assets (ID: " +
+                             to_string(asset_id) + ")");
+            }
+            if (check_transferable && !get_asset_flags(*global_itr).transferable) {
+                check(false, "At least one asset isn't transferable (ID: " + to_string(asset_id) + ")");
+            }
+
+            collection_to_assets_transferred[global_itr->collection_name].push_back(asset_id);
+
+            //Only the owner changes, so the size of the row and the RAM of its ram_payer stay the same
+            globalassets.modify(global_itr, same_payer, [&](auto &_asset) {
+                _asset.owner = to;
+            });
+            continue;
+        }
+
+        auto assetv2_itr = from_assetsv2.find(asset_id);
+        bool is_assetv2 = assetv2_itr != from_assetsv2.end();
+
+        auto asset_itr = is_assetv2 ? from_assets.end() : from_assets.find(asset_id);
+        if (!is_assetv2 && asset_itr == from_assets.end()) {
+            check(false, string(from_description) + " doesn't own at least one of the provided assets (ID: " +
+                         to_string(asset_id) + ")");
+        }
+
+        if (check_transferable) {
+            bool transferable = is_assetv2
+                                ? get_asset_flags(*assetv2_itr).transferable
+                                : get_asset_flags(*asset_itr).transferable;
+            if (!transferable) {
+                check(false, "At least one asset isn't transferable (ID: " + to_string(asset_id) + ")");
+            }
+        }
+
+        //This is needed for sending notifications later
+        name collection_name = is_assetv2 ? assetv2_itr->collection_name : asset_itr->collection_name;
+        collection_to_assets_transferred[collection_name].push_back(asset_id);
+
+        name ram_payer = is_assetv2 ? assetv2_itr->ram_payer : asset_itr->ram_payer;
+        bool payer_authorized = has_auth(ram_payer);
+        uint64_t current_ram = is_assetv2 ? get_asset_row_ram(*assetv2_itr) : get_asset_row_ram(*asset_itr);
+
+        //Assets are converted if their ram_payer authorized the action or if the new row doesn't need more RAM
+        globalassets_s global_asset = {};
+        bool to_global = false;
+        if (global_assets) {
+            global_asset = is_assetv2
+                           ? globalassets_s{
+                               asset_id,
+                               to,
+                               assetv2_itr->collection_name,
+                               ram_payer,
+                               assetv2_itr->flags,
+                               assetv2_itr->data
+                           }
+                           : pack_global_asset(to, *asset_itr);
+            to_global = payer_authorized || get_asset_row_ram(global_asset) <= current_ram;
+        }
+        assetsv2_s compact_asset = {};
+        bool to_compact = is_assetv2;
+        if (!to_global && !is_assetv2 && compact_assets) {
+            compact_asset = pack_asset(*asset_itr);
+            to_compact = payer_authorized || get_asset_row_ram(compact_asset) <= current_ram;
+        }
+
+        if (to_global) {
+            globalassets.emplace(ram_payer, [&](auto &_asset) {
+                _asset = std::move(global_asset);
+            });
+        } else if (to_compact) {
+            if (!checked_scopev2) {
+                checked_scopev2 = true;
+                if (to_assetsv2.begin() == to_assetsv2.end()) {
+                    to_assetsv2.emplace(scope_payer, [&](auto &_asset) {
+                        _asset.asset_id = ULLONG_MAX;
+                        _asset.collection_name = name("");
+                        _asset.ram_payer = scope_payer;
+                        _asset.flags = 0;
+                        _asset.data = toVarintBytes(zigzagEncode(-1)); //template_id -1, needed for the index
+                    });
+                    added_dummyv2 = true;
+                }
+            }
+
+            if (is_assetv2) {
+                compact_asset = *assetv2_itr;
+            }
+            to_assetsv2.emplace(ram_payer, [&](auto &_asset) {
+                _asset = std::move(compact_asset);
+            });
+        } else {
+            if (!checked_scope) {
+                checked_scope = true;
+                if (to_assets.begin() == to_assets.end()) {
+                    to_assets.emplace(scope_payer, [&](auto &_asset) {
+                        _asset.asset_id = ULLONG_MAX;
+                        _asset.collection_name = name("");
+                        _asset.schema_name = name("");
+                        _asset.template_id = -1;
+                        _asset.ram_payer = scope_payer;
+                        _asset.backed_tokens = {};
+                        _asset.immutable_serialized_data = {};
+                        _asset.mutable_serialized_data = {};
+                    });
+                    added_dummy = true;
+                }
+            }
+
+            to_assets.emplace(asset_itr->ram_payer, [&](auto &_asset) {
+                _asset = *asset_itr;
+            });
+        }
+
+        if (is_assetv2) {
+            from_assetsv2.erase(assetv2_itr);
+        } else {
+            from_assets.erase(asset_itr);
+        }
+    }
+
+    if (added_dummy) {
+        to_assets.erase(to_assets.find(ULLONG_MAX));
+    }
+    if (added_dummyv2) {
+        to_assetsv2.erase(to_assetsv2.find(ULLONG_MAX));
+    }
+
+    return collection_to_assets_transferred;
+}
+
+
+/**
+*  The specified asset is backed by the specified quantitiy.
+*  This is done in an internal function because it is needed both in the mintasset and the backasset action
+*/
+void atomicassets::internal_back_asset(
+    name payer,
+    name asset_owner,
+    uint64_t asset_id,
+    asset token_to_back
+) {
+    check(token_to_back.amount > 0, "token_to_back must be positive");
+
+    //The internal_decrease_balance function will throw if payer does not have a sufficient balance
+    internal_decrease_balance(payer, token_to_back);
+
+    assets_s owner_asset;
+    check(find_asset(asset_owner, asset_id, owner_asset),
+        "The specified owner does not own the asset with the specified ID");
+
+    check(get_asset_flags(owner_asset).burnable, "The asset is not burnable. Only burnable assets can be backed.");
+
+    bool found_backed_token = false;
+    for (asset &token : owner_asset.backed_tokens) {
+        if (token.symbol == token_to_back.symbol) {
+            found_backed_token = true;
+            token.amount += token_to_back.amount;
+            break;
+        }
+    }
+    if (!found_backed_token) {
+        owner_asset.backed_tokens.push_back(token_to_back);
+    }
+
+    owner_asset.ram_payer = payer;
+    internal_update_asset(asset_owner, owner_asset);
+
+    action(
+        permission_level{get_self(), name("active")},
+        get_self(),
+        name("logbackasset"),
+        make_tuple(asset_owner, asset_id, token_to_back)
+    ).send();
+}
+
+
+/**
+*  Moves the balance row of owner from the balances table into the symbalances table, if it still has one
+*  The new rows are paid by owner, so this must only be called in actions that owner authorized
+*
+*  The balances table allowed the same symbol code with different precisions, which the symbalances table can only
+*  hold once. Quantities whose symbol code is already in the symbalances table stay in the balances row, and are
+*  changed there by internal_increase_balance and internal_decrease_balance
+*/
+void atomicassets::internal_migrate_balance(name owner) {
+    auto balance_itr = balances.find(owner.value);
+    if (balance_itr == balances.end()) {
+        return;
+    }
+
+    symbalances_t owner_balances = get_symbol_balances(owner);
+    vector <asset> kept_quantities = {};
+    for (const asset &quantity : balance_itr->quantities) {
+        if (owner_balances.find(quantity.symbol.code().raw()) != owner_balances.end()) {
+            kept_quantities.push_back(quantity);
+            continue;
+        }
+        owner_balances.emplace(owner, [&](auto &_balance) {
+            _balance.quantity = quantity;
+        });
+    }
+
+    if (kept_quantities.size() == 0) {
+        balances.erase(balance_itr);
+    } else if (kept_quantities.size() != balance_itr->quantities.size()) {
+        balances.modify(balance_itr, same_payer, [&](auto &_balance) {
+            _balance.quantities = kept_quantities;
+        });
+    }
+}
+
+
+/**
+*  Returns the supported token with the specified symbol
+*  Throws if no token with this symbol is supported
+*/
+extended_symbol atomicassets::get_supported_token(symbol token_symbol) {
+    auto suptoken_itr = suptokens.require_find(token_symbol.code().raw(),
+        "The specified symbol is not supported");
+    check(suptoken_itr->token.get_symbol() == token_symbol, "The specified symbol is not supported");
+
+    return suptoken_itr->token;
+}
+
+
+/**
+*  Decreases the balance of a specified account by a specified quantity
+*  If the specified account does not have at least as much tokens in the balance as should be removed
+*  the transaction will fail
+*  Requires the authorization of owner (see internal_migrate_balance)
+*/
+void atomicassets::internal_decrease_balance(
+    name owner,
+    asset quantity
+) {
+    internal_migrate_balance(owner);
+
+    symbalances_t owner_balances = get_symbol_balances(owner);
+    auto balance_itr = owner_balances.find(quantity.symbol.code().raw());
+    if (balance_itr != owner_balances.end() && balance_itr->quantity.symbol != quantity.symbol) {
+        internal_decrease_legacy_balance(owner, quantity);
+        return;
+    }
+    check(balance_itr != owner_balances.end(),
+        "The specified account does not have a balance for the symbol specified in the quantity");
+    check(balance_itr->quantity.amount >= quantity.amount,
+        "The specified account's balance is lower than the specified quantity");
+
+    if (balance_itr->quantity.amount == quantity.amount) {
+        owner_balances.erase(balance_itr);
+    } else {
+        owner_balances.modify(balance_itr, same_payer, [&](auto &_balance) {
+            _balance.quantity.amount -= quantity.amount;
+        });
+    }
+}
+
+
+/**
+*  Adds the specified quantities to the balance of the specified account
+*  Balance rows that don't exist yet are created and paid for by the account,
+*  so this requires the authorization of owner
+*/
+void atomicassets::internal_increase_balance(
+    name owner,
+    const vector <asset> &quantities
+) {
+    internal_migrate_balance(owner);
+
+    symbalances_t owner_balances = get_symbol_balances(owner);
+    for (const asset &quantity : quantities) {
+        auto balance_itr = owner_balances.find(quantity.symbol.code().raw());
+        if (balance_itr == owner_balances.end()) {
+            owner_balances.emplace(owner, [&](auto &_balance) {
+                _balance.quantity = quantity;
+            });
+        } else if (balance_itr->quantity.symbol != quantity.symbol) {
+            internal_increase_legacy_balance(owner, quantity);
+        } else {
+            owner_balances.modify(balance_itr, same_payer, [&](auto &_balance) {
+                _balance.quantity.amount += quantity.amount;
+            });
+        }
+    }
+}
+
+
+/**
+*  Decreases a balance that is kept in the balances table, because the symbalances table already has a row
+*  with the same symbol code and a different precision (see internal_migrate_balance)
+*/
+void atomicassets::internal_decrease_legacy_balance(
+    name owner,
+    asset quantity
+) {
+    auto balance_itr = balances.find(owner.value);
+    check(balance_itr != balances.end(),
+        "The specified account does not have a balance for the symbol specified in the quantity");
+
+    vector <asset> quantities = balance_itr->quantities;
+    bool found_token = false;
+    for (auto itr = quantities.begin(); itr != quantities.end(); itr++) {
+        if (itr->symbol == quantity.symbol) {
+            found_token = true;
+            check(itr->amount >= quantity.amount,
+                "The specified account's balance is lower than the specified quantity");
+            itr->amount -= quantity.amount;
+            if (itr->amount == 0) {
+                quantities.erase(itr);
+            }
+            break;
+        }
+    }
+    check(found_token,
+        "The specified account does not have a balance for the symbol specified in the quantity");
+
+    if (quantities.size() > 0) {
+        balances.modify(balance_itr, same_payer, [&](auto &_balance) {
+            _balance.quantities = quantities;
+        });
+    } else {
+        balances.erase(balance_itr);
+    }
+}
+
+
+/**
+*  Increases a balance that has to be kept in the balances table, because the symbalances table already has a row
+*  with the same symbol code and a different precision (see internal_migrate_balance)
+*  A new balances row is paid by owner, so this requires the authorization of owner
+*/
+void atomicassets::internal_increase_legacy_balance(
+    name owner,
+    asset quantity
+) {
+    auto balance_itr = balances.find(owner.value);
+    if (balance_itr == balances.end()) {
+        balances.emplace(owner, [&](auto &_balance) {
+            _balance.owner = owner;
+            _balance.quantities = {quantity};
+        });
+        return;
+    }
+
+    vector <asset> quantities = balance_itr->quantities;
+    bool found_token = false;
+    for (asset &token : quantities) {
+        if (token.symbol == quantity.symbol) {
+            found_token = true;
+            token.amount += quantity.amount;
+            break;
+        }
+    }
+    if (!found_token) {
+        quantities.push_back(quantity);
+    }
+    balances.modify(balance_itr, same_payer, [&](auto &_balance) {
+        _balance.quantities = quantities;
+    });
+}
+
+
+/**
+* Notifies all of a collection's notify accounts that subscribed to the event using require_recipient
+*/
+void atomicassets::notify_collection_accounts(
+    name collection_name,
+    uint8_t event
 ) {
     auto collection_itr = collections.require_find(collection_name.value,
         "No collection with this name exists");
 
-    for (const name &notify_account : collection_itr->notify_accounts) {
-        require_recipient(notify_account);
+    const vector <name> &notify_accounts = collection_itr->notify_accounts;
+    if (!collection_itr->notify_events.has_value()) {
+        for (const name &notify_account : notify_accounts) {
+            require_recipient(notify_account);
+        }
+        return;
+    }
+
+    const vector <uint8_t> &notify_events = collection_itr->notify_events.value();
+    for (size_t i = 0; i < notify_accounts.size(); i++) {
+        if (notify_events[i] & event) {
+            require_recipient(notify_accounts[i]);
+        }
+    }
+}
+
+
+/**
+*  Copies the authorized_accounts of a collection to the colauths table,
+*  if this hasn't happened yet because the collection was created before the table existed
+*  The rows are paid by the collection author
+*/
+void atomicassets::internal_copy_collection_auths(const collections_s &collection) {
+    colauths_t collection_auths = get_collection_auths(collection.collection_name);
+    if (collection_auths.begin() != collection_auths.end()) {
+        return;
+    }
+
+    for (const name &account : collection.authorized_accounts) {
+        collection_auths.emplace(collection.author, [&](auto &_auth) {
+            _auth.account = account;
+        });
+    }
+}
+
+
+/**
+* Adds a reference to the blob with the provided data in the collection's blobs table, creating it if necessary
+* The ram_payer only pays if a new blob row is created. Adding a reference doesn't change the size of the row.
+*
+* Returns false if the data should be stored inline instead. This is the case for data shorter than
+* MIN_SHARED_BLOB_SIZE, and for the (practically impossible) case of a different blob with the same blob_id
+*/
+bool atomicassets::internal_store_blob(
+    name collection_name,
+    const vector <uint8_t> &data,
+    name ram_payer,
+    uint64_t &blob_id
+) {
+    if (data.size() < MIN_SHARED_BLOB_SIZE) {
+        return false;
+    }
+
+    checksum256 data_hash = sha256((const char *) data.data(), data.size());
+    auto hash_bytes = data_hash.extract_as_byte_array();
+    blob_id = 0;
+    for (int i = 0; i < 8; i++) {
+        blob_id |= (uint64_t) hash_bytes[i] << (8 * i);
+    }
+
+    blobs_t &collection_blobs = get_cached_blobs(collection_name);
+    auto blob_itr = collection_blobs.find(blob_id);
+    if (blob_itr == collection_blobs.end()) {
+        collection_blobs.emplace(ram_payer, [&](auto &_blob) {
+            _blob.blob_id = blob_id;
+            _blob.data_hash = data_hash;
+            _blob.references = 1;
+            _blob.data = data;
+        });
+        return true;
+    }
+
+    if (blob_itr->data_hash != data_hash) {
+        return false;
+    }
+
+    collection_blobs.modify(blob_itr, same_payer, [&](auto &_blob) {
+        _blob.references++;
+    });
+    return true;
+}
+
+
+/**
+* Removes a reference to a blob, and erases the blob if it was the last one
+*/
+void atomicassets::internal_release_blob(
+    name collection_name,
+    uint64_t blob_id
+) {
+    blobs_t &collection_blobs = get_cached_blobs(collection_name);
+    auto blob_itr = collection_blobs.require_find(blob_id,
+        "The referenced blob does not exist");
+
+    if (blob_itr->references <= 1) {
+        collection_blobs.erase(blob_itr);
+    } else {
+        collection_blobs.modify(blob_itr, same_payer, [&](auto &_blob) {
+            _blob.references--;
+        });
+    }
+}
+
+
+/**
+* Creates the supplies row of a template that was created before the supplies table existed
+* The issued_supply is copied from the template row, which is not updated anymore afterwards
+*/
+void atomicassets::internal_init_template_supply(
+    name collection_name,
+    const templates_s &template_row,
+    name ram_payer
+) {
+    supplies_t collection_supplies = get_supplies(collection_name);
+    if (collection_supplies.find(template_row.template_id) != collection_supplies.end()) {
+        return;
+    }
+
+    collection_supplies.emplace(ram_payer, [&](auto &_supply) {
+        _supply.template_id = template_row.template_id;
+        _supply.issued_supply = template_row.issued_supply;
+        _supply.burned_supply = 0;
+        _supply.reserved_supply = 0;
+        _supply.locked = false;
+    });
+}
+
+
+/**
+* Increases the issued supply of a template by amount
+*
+* If from_reserved_supply is set, the assets were already counted in the reserved supply when they were added to an
+* airdrop, so they are only moved from the reserved to the issued supply. Otherwise, the issued and the reserved
+* supply together must not exceed the template's max_supply, so that open airdrops can always be completed.
+* Templates that don't have a supplies row yet get one, paid by ram_payer.
+*/
+void atomicassets::internal_issue_template_supply(
+    name collection_name,
+    const templates_s &template_row,
+    uint64_t amount,
+    name ram_payer,
+    bool from_reserved_supply
+) {
+    supplies_t collection_supplies = get_supplies(collection_name);
+
+    if (from_reserved_supply) {
+        auto supply_itr = collection_supplies.require_find(template_row.template_id,
+            "The template doesn't have a reserved supply");
+        check(supply_itr->reserved_supply >= amount, "The template's reserved supply is too small");
+
+        collection_supplies.modify(supply_itr, same_payer, [&](auto &_supply) {
+            _supply.reserved_supply -= amount;
+            _supply.issued_supply += amount;
+        });
+        return;
+    }
+
+    internal_init_template_supply(collection_name, template_row, ram_payer);
+    auto supply_itr = collection_supplies.find(template_row.template_id);
+    check(!supply_itr->locked, "The template is locked");
+
+    if (template_row.max_supply > 0) {
+        check((uint64_t) supply_itr->issued_supply + supply_itr->reserved_supply + amount <= template_row.max_supply,
+            "The template's maxsupply has already been reached");
+    }
+
+    collection_supplies.modify(supply_itr, same_payer, [&](auto &_supply) {
+        _supply.issued_supply += amount;
+    });
+}
+
+
+/**
+* Changes the reserved supply of a template, which counts the assets that open airdrops still have to mint
+* Increasing it throws if the issued and the reserved supply together would exceed the template's max_supply
+* The template needs to have a supplies row already, see internal_init_template_supply
+*/
+void atomicassets::internal_reserve_template_supply(
+    name collection_name,
+    const templates_s &template_row,
+    int64_t amount
+) {
+    supplies_t collection_supplies = get_supplies(collection_name);
+    auto supply_itr = collection_supplies.require_find(template_row.template_id,
+        "The template doesn't have a supplies row");
+
+    if (amount > 0 && template_row.max_supply > 0) {
+        check((uint64_t) supply_itr->issued_supply + supply_itr->reserved_supply + amount <= template_row.max_supply,
+            "The airdrop would exceed the template's maxsupply");
+    }
+
+    collection_supplies.modify(supply_itr, same_payer, [&](auto &_supply) {
+        _supply.reserved_supply += amount;
+    });
+}
+
+
+/**
+* Increases the burned supply of a template by amount
+* Burns of templates without a supplies row are not counted, so that burning never costs the owner any RAM
+*/
+void atomicassets::internal_burn_template_supply(
+    name collection_name,
+    int32_t template_id,
+    uint32_t amount
+) {
+    supplies_t collection_supplies = get_supplies(collection_name);
+    auto supply_itr = collection_supplies.find(template_id);
+    if (supply_itr == collection_supplies.end()) {
+        return;
     }
+
+    collection_supplies.modify(supply_itr, same_payer, [&](auto &_supply) {
+        _supply.burned_supply += amount;
+    });
 }
 
 
 /**
 * Checks if the account_to_check is in the authorized_accounts vector of the specified collection
+* This is a single lookup in the colauths table. Only if that fails, the collection itself is checked,
+* because collections created before the colauths table existed might not have been copied to it yet
 */
 void atomicassets::check_has_collection_auth(
     name account_to_check,
     name collection_name,
     string error_message
 ) {
+    colauths_t collection_auths = get_collection_auths(collection_name);
+    if (collection_auths.find(account_to_check.value) != collection_auths.end()) {
+        return;
+    }
+
     auto collection_itr = collections.require_find(collection_name.value,
         "No collection with this name exists");
 
@@ -1470,11 +3141,511 @@ void atomicassets::check_name_length(
 }
 
 
+/**
+* Returns the current counters
+* Contracts that were deployed before the counters table existed still have them in the config singleton.
+* In that case they are read from there once, and are written to the counters table by the calling action.
+*/
+atomicassets::counters_s atomicassets::get_counters() {
+    if (counters.exists()) {
+        return counters.get();
+    }
+
+    config_s current_config = config.get();
+    return counters_s{
+        current_config.asset_counter,
+        current_config.template_counter,
+        current_config.offer_counter
+    };
+}
+
+
+/**
+* Returns the compiled type code of each format line of a schema
+* Schemas written before the type codes were stored don't have them, so they are compiled from the format instead
+*/
+vector <uint8_t> atomicassets::get_schema_type_codes(const schemas_s &schema) {
+    if (schema.type_codes.has_value()) {
+        return schema.type_codes.value();
+    }
+    return get_type_codes(schema.format);
+}
+
+
+/**
+* Returns the compiled type code of each line of the collection format
+* Configs written before the type codes were stored don't have them, so they are compiled from the format instead
+*/
+vector <uint8_t> atomicassets::get_collection_format_types(const config_s &current_config) {
+    if (current_config.collection_format_types.has_value()) {
+        return current_config.collection_format_types.value();
+    }
+    return get_type_codes(current_config.collection_format);
+}
+
+
+/**
+* Returns the templates table of a collection
+* The table handle is kept for the rest of the action, so that its row cache is reused by later lookups
+* The other get_cached_* functions keep their table handles in the same way
+*/
+atomicassets::templates_t &atomicassets::get_cached_templates(name collection_name) {
+    return templates_cache.try_emplace(collection_name, get_self(), collection_name.value).first->second;
+}
+
+
+/**
+* Returns the transferable and burnable flags of a template
+* The template must exist. The flags are cached for the rest of the action.
+*/
+const atomicassets::template_flags &atomicassets::get_template_flags(name collection_name, int32_t template_id) {
+    pair <name, int32_t> template_key = {collection_name, template_id};
+    auto flags_itr = template_flags_cache.find(template_key);
+    if (flags_itr == template_flags_cache.end()) {
+        auto template_itr = get_cached_templates(collection_name).find(template_id);
+        flags_itr = template_flags_cache.emplace(
+            template_key,
+            template_flags{template_itr->transferable, template_itr->burnable}
+        ).first;
+    }
+    return flags_itr->second;
+}
+
+
+/**
+* Returns the blobs table of a collection
+*/
+atomicassets::blobs_t &atomicassets::get_cached_blobs(name collection_name) {
+    return blobs_cache.try_emplace(collection_name, get_self(), collection_name.value).first->second;
+}
+
+
+/**
+* Returns the immutable serialized data of an asset, reading it from the blobs table if the asset references a blob
+*/
+vector <uint8_t> atomicassets::get_immutable_data(const assets_s &asset) {
+    if (asset.immutable_blob_id.has_value()) {
+        return get_cached_blobs(asset.collection_name).get(asset.immutable_blob_id.value(),
+            "The immutable data of the asset does not exist").data;
+    }
+    return asset.immutable_serialized_data;
+}
+
+
+/**
+* Returns the immutable serialized data of a template, reading it from the blobs table if the template references a blob
+*/
+vector <uint8_t> atomicassets::get_immutable_data(name collection_name, const templates_s &template_row) {
+    if (template_row.immutable_blob_id.has_value()) {
+        return get_cached_blobs(collection_name).get(template_row.immutable_blob_id.value(),
+            "The immutable data of the template does not exist").data;
+    }
+    return template_row.immutable_serialized_data;
+}
+
+
+/**
+* Returns the transferable and burnable flags of an asset
+* They are read from the asset itself if it stores them, and otherwise from its template
+*/
+atomicassets::template_flags atomicassets::get_asset_flags(const assets_s &asset) {
+    if (asset.flags.has_value()) {
+        return template_flags{
+            (asset.flags.value() & ASSET_FLAG_TRANSFERABLE) != 0,
+            (asset.flags.value() & ASSET_FLAG_BURNABLE) != 0
+        };
+    }
+    if (asset.template_id < 0) {
+        return template_flags{true, true};
+    }
+    return get_template_flags(asset.collection_name, asset.template_id);
+}
+
+
+/**
+* Returns the features row, which is only read once per action
+*/
+const atomicassets::features_s &atomicassets::get_features() {
+    if (!features_cached) {
+        features_cache = features.get_or_default();
+        features_cached = true;
+    }
+    return features_cache;
+}
+
+
+bool atomicassets::is_feature_enabled(uint64_t feature) {
+    return (get_features().enabled_features & feature) != 0;
+}
+
+
+/**
+* Returns the transferable and burnable flags of an asset in the assetsv2 table
+* Only the template_id is decoded if the asset doesn't store its own flags
+*/
+atomicassets::template_flags atomicassets::get_asset_flags(const assetsv2_s &asset) {
+    if (asset.flags & ASSETV2_HAS_FLAGS) {
+        return template_flags{
+            (asset.flags & ASSET_FLAG_TRANSFERABLE) != 0,
+            (asset.flags & ASSET_FLAG_BURNABLE) != 0
+        };
+    }
+    int32_t template_id = asset.get_template_id();
+    if (template_id < 0) {
+        return template_flags{true, true};
+    }
+    return get_template_flags(asset.collection_name, template_id);
+}
+
+
+/**
+* Returns the transferable and burnable flags of an asset in the globalassets table
+*/
+atomicassets::template_flags atomicassets::get_asset_flags(const globalassets_s &asset) {
+    if (asset.flags & ASSETV2_HAS_FLAGS) {
+        return template_flags{
+            (asset.flags & ASSET_FLAG_TRANSFERABLE) != 0,
+            (asset.flags & ASSET_FLAG_BURNABLE) != 0
+        };
+    }
+    int32_t template_id = asset.get_template_id();
+    if (template_id < 0) {
+        return template_flags{true, true};
+    }
+    return get_template_flags(asset.collection_name, template_id);
+}
+
+
+bool atomicassets::use_compact_assets() {
+    return is_feature_enabled(FEATURE_COMPACT_ASSETS);
+}
+
+
+bool atomicassets::use_global_assets() {
+    return is_feature_enabled(FEATURE_GLOBAL_ASSETS);
+}
+
+
+/**
+* Checks if FEATURE_GLOBAL_ASSETS has ever been enabled
+* Otherwise the globalassets table is empty, and assets don't need to be looked up in it
+*/
+bool atomicassets::global_assets_used() {
+    return (get_features().used_features & FEATURE_GLOBAL_ASSETS) != 0;
+}
+
+
+/**
+* Returns the assets table of an owner
+*/
+atomicassets::assets_t &atomicassets::get_cached_assets(name owner) {
+    return assets_cache.try_emplace(owner, get_self(), owner.value).first->second;
+}
+
+
+/**
+* Returns the assetsv2 table of an owner
+*/
+atomicassets::assetsv2_t &atomicassets::get_cached_assetsv2(name owner) {
+    return assetsv2_cache.try_emplace(owner, get_self(), owner.value).first->second;
+}
+
+
+/**
+* Converts an asset into the compact assetsv2 layout, see assetsv2_s for the format of the packed data
+*/
+atomicassets::assetsv2_s atomicassets::pack_asset(const assets_s &asset_row) {
+    uint8_t flags = 0;
+    if (asset_row.flags.has_value()) {
+        flags |= ASSETV2_HAS_FLAGS | (asset_row.flags.value() & (ASSET_FLAG_TRANSFERABLE | ASSET_FLAG_BURNABLE));
+    }
+
+    vector <uint8_t> data = toVarintBytes(zigzagEncode(asset_row.template_id));
+    auto append = [&](const vector <uint8_t> &bytes) {
+        data.insert(data.end(), bytes.begin(), bytes.end());
+    };
+
+    if (asset_row.template_id < 0) {
+        flags |= ASSETV2_HAS_SCHEMA;
+        append(toIntBytes(asset_row.schema_name.value, 8));
+    }
+    if (asset_row.backed_tokens.size() != 0) {
+        flags |= ASSETV2_HAS_BACKED_TOKENS;
+        append(toVarintBytes(asset_row.backed_tokens.size()));
+        for (const asset &token : asset_row.backed_tokens) {
+            append(toVarintBytes(token.amount));
+            append(toIntBytes(token.symbol.raw(), 8));
+        }
+    }
+    if (asset_row.immutable_blob_id.has_value()) {
+        flags |= ASSETV2_HAS_BLOB;
+        append(toIntBytes(asset_row.immutable_blob_id.value(), 8));
+    }
+    append(toVarintBytes(asset_row.immutable_serialized_data.size()));
+    append(asset_row.immutable_serialized_data);
+    append(asset_row.mutable_serialized_data);
+
+    return assetsv2_s{asset_row.asset_id, asset_row.collection_name, asset_row.ram_payer, flags, std::move(data)};
+}
+
+
+/**
+* Converts an asset from the compact assetsv2 layout back into an assets_s
+* The schema_name of assets with a template is left empty, so that the template doesn't have to be read.
+* Callers that need it use get_asset_schema
+*/
+atomicassets::assets_s atomicassets::unpack_asset(const assetsv2_s &asset_row) {
+    assets_s unpacked = {};
+    unpacked.asset_id = asset_row.asset_id;
+    unpacked.collection_name = asset_row.collection_name;
+    unpacked.ram_payer = asset_row.ram_payer;
+
+    auto data_itr = asset_row.data.begin();
+    unpacked.template_id = (int32_t) zigzagDecode(unsignedFromVarintBytes(data_itr));
+
+    if (asset_row.flags & ASSETV2_HAS_SCHEMA) {
+        unpacked.schema_name = name(unsignedFromIntBytes(data_itr, 8));
+    }
+
+    if (asset_row.flags & ASSETV2_HAS_BACKED_TOKENS) {
+        uint64_t token_count = unsignedFromVarintBytes(data_itr);
+        for (uint64_t i = 0; i < token_count; i++) {
+            int64_t amount = (int64_t) unsignedFromVarintBytes(data_itr);
+            unpacked.backed_tokens.push_back(asset(amount, symbol(unsignedFromIntBytes(data_itr, 8))));
+        }
+    }
+
+    if (asset_row.flags & ASSETV2_HAS_FLAGS) {
+        unpacked.flags.emplace(asset_row.flags & (ASSET_FLAG_TRANSFERABLE | ASSET_FLAG_BURNABLE));
+    }
+    if (asset_row.flags & ASSETV2_HAS_BLOB) {
+        unpacked.immutable_blob_id.emplace(unsignedFromIntBytes(data_itr, 8));
+    }
+
+    uint64_t immutable_length = unsignedFromVarintBytes(data_itr);
+    unpacked.immutable_serialized_data.assign(data_itr, data_itr + immutable_length);
+    data_itr += immutable_length;
+    unpacked.mutable_serialized_data.assign(data_itr, asset_row.data.end());
+
+    return unpacked;
+}
+
+
+/**
+* Converts an asset into a row of the globalassets table, which uses the same packed data as the assetsv2 table
+*/
+atomicassets::globalassets_s atomicassets::pack_global_asset(name owner, const assets_s &asset_row) {
+    assetsv2_s packed = pack_asset(asset_row);
+    return globalassets_s{
+        packed.asset_id,
+        owner,
+        packed.collection_name,
+        packed.ram_payer,
+        packed.flags,
+        std::move(packed.data)
+    };
+}
+
+
+/**
+* Returns the schema_name of an asset, reading it from the template for unpacked assets that don't store it
+*/
+name atomicassets::get_asset_schema(const assets_s &asset) {
+    if (asset.schema_name != name()) {
+        return asset.schema_name;
+    }
+    return get_cached_templates(asset.collection_name).get(asset.template_id,
+        "The template of the asset does not exist").schema_name;
+}
+
+
+atomicassets::assets_s atomicassets::unpack_asset(const globalassets_s &asset_row) {
+    return unpack_asset(assetsv2_s{
+        asset_row.asset_id,
+        asset_row.collection_name,
+        asset_row.ram_payer,
+        asset_row.flags,
+        asset_row.data
+    });
+}
+
+
+/**
+* Looks up an asset of owner in the globalassets, the assetsv2 and the assets table
+* Returns false if owner doesn't own an asset with this id
+*/
+bool atomicassets::find_asset(name owner, uint64_t asset_id, assets_s &asset) {
+    auto global_itr = global_assets_used() ? globalassets.find(asset_id) : globalassets.end();
+    if (global_itr != globalassets.end()) {
+        if (global_itr->owner != owner) {
+            return false;
+        }
+        asset = unpack_asset(*global_itr);
+        return true;
+    }
+
+    assetsv2_t &owner_assetsv2 = get_cached_assetsv2(owner);
+    auto assetv2_itr = owner_assetsv2.find(asset_id);
+    if (assetv2_itr != owner_assetsv2.end()) {
+        asset = unpack_asset(*assetv2_itr);
+        return true;
+    }
+
+    assets_t &owner_assets = get_cached_assets(owner);
+    auto asset_itr = owner_assets.find(asset_id);
+    if (asset_itr == owner_assets.end()) {
+        return false;
+    }
+    asset = *asset_itr;
+    return true;
+}
+
+
+/**
+* Checks if owner owns the asset, without unpacking it
+*/
+bool atomicassets::owns_asset(name owner, uint64_t asset_id) {
+    auto global_itr = global_assets_used() ? globalassets.find(asset_id) : globalassets.end();
+    if (global_itr != globalassets.end()) {
+        return global_itr->owner == owner;
+    }
+
+    assetsv2_t &owner_assetsv2 = get_cached_assetsv2(owner);
+    if (owner_assetsv2.find(asset_id) != owner_assetsv2.end()) {
+        return true;
+    }
+
+    assets_t &owner_assets = get_cached_assets(owner);
+    return owner_assets.find(asset_id) != owner_assets.end();
+}
+
+
+/**
+* Checks if an offer can still be accepted, which is the case if it has not expired and both sides still own
+* all of their assets
+*/
+bool atomicassets::is_offer_acceptable(const offers_s &offer) {
+    if (offer.by_expiry() <= current_time_point().sec_since_epoch()) {
+        return false;
+    }
+    for (uint64_t asset_id : offer.sender_asset_ids) {
+        if (!owns_asset(offer.sender, asset_id)) {
+            return false;
+        }
+    }
+    for (uint64_t asset_id : offer.recipient_asset_ids) {
+        if (!owns_asset(offer.recipient, asset_id)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/**
+* Checks if owner already has a scope in the table that new assets are stored in
+* The globalassets table only has the scope of the contract, which exists once any asset was stored in it
+*/
+bool atomicassets::asset_scope_exists(name owner) {
+    if (use_global_assets()) {
+        return globalassets.begin() != globalassets.end();
+    }
+    if (use_compact_assets()) {
+        assetsv2_t &owner_assetsv2 = get_cached_assetsv2(owner);
+        return owner_assetsv2.begin() != owner_assetsv2.end();
+    }
+    assets_t &owner_assets = get_cached_assets(owner);
+    return owner_assets.begin() != owner_assets.end();
+}
+
+
+/**
+* Stores a new asset of owner, in the globalassets table if FEATURE_GLOBAL_ASSETS is enabled,
+* and otherwise in the assetsv2 table if FEATURE_COMPACT_ASSETS is enabled
+* The RAM is paid by the asset's ram_payer
+*/
+void atomicassets::internal_store_asset(name owner, const assets_s &asset) {
+    if (use_global_assets()) {
+        globalassets.emplace(asset.ram_payer, [&](auto &_asset) {
+            _asset = pack_global_asset(owner, asset);
+        });
+    } else if (use_compact_assets()) {
+        get_cached_assetsv2(owner).emplace(asset.ram_payer, [&](auto &_asset) {
+            _asset = pack_asset(asset);
+        });
+    } else {
+        get_cached_assets(owner).emplace(asset.ram_payer, [&](auto &_asset) {
+            _asset = asset;
+        });
+    }
+}
+
+
+/**
+* Writes a changed asset back into the table that it is stored in
+* The RAM is paid by the asset's ram_payer, so callers that change the payer have to set it first
+*/
+void atomicassets::internal_update_asset(name owner, const assets_s &asset) {
+    auto global_itr = global_assets_used() ? globalassets.find(asset.asset_id) : globalassets.end();
+    if (global_itr != globalassets.end()) {
+        globalassets.modify(global_itr, asset.ram_payer, [&](auto &_asset) {
+            _asset = pack_global_asset(owner, asset);
+        });
+        return;
+    }
+
+    assetsv2_t &owner_assetsv2 = get_cached_assetsv2(owner);
+    auto assetv2_itr = owner_assetsv2.find(asset.asset_id);
+    if (assetv2_itr != owner_assetsv2.end()) {
+        owner_assetsv2.modify(assetv2_itr, asset.ram_payer, [&](auto &_asset) {
+            _asset = pack_asset(asset);
+        });
+        return;
+    }
+
+    assets_t &owner_assets = get_cached_assets(owner);
+    auto asset_itr = owner_assets.require_find(asset.asset_id,
+        "No asset with this id exists");
+    owner_assets.modify(asset_itr, asset.ram_payer, [&](auto &_asset) {
+        _asset = asset;
+    });
+}
+
+
+/**
+* Erases an asset of owner from the table that it is stored in
+*/
+void atomicassets::internal_erase_asset(name owner, uint64_t asset_id) {
+    auto global_itr = global_assets_used() ? globalassets.find(asset_id) : globalassets.end();
+    if (global_itr != globalassets.end()) {
+        check(global_itr->owner == owner, "No asset with this id exists");
+        globalassets.erase(global_itr);
+        return;
+    }
+
+    assetsv2_t &owner_assetsv2 = get_cached_assetsv2(owner);
+    auto assetv2_itr = owner_assetsv2.find(asset_id);
+    if (assetv2_itr != owner_assetsv2.end()) {
+        owner_assetsv2.erase(assetv2_itr);
+        return;
+    }
+
+    assets_t &owner_assets = get_cached_assets(owner);
+    owner_assets.erase(owner_assets.require_find(asset_id,
+        "No asset with this id exists"));
+}
+
+
 atomicassets::assets_t atomicassets::get_assets(name acc) {
     return assets_t(get_self(), acc.value);
 }
 
 
+atomicassets::assetsv2_t atomicassets::get_assetsv2(name acc) {
+    return assetsv2_t(get_self(), acc.value);
+}
+
+
 atomicassets::schemas_t atomicassets::get_schemas(name collection_name) {
     return schemas_t(get_self(), collection_name.value);
 }
@@ -1482,4 +3653,42 @@ atomicassets::schemas_t atomicassets::get_schemas(name collection_name) {
 
 atomicassets::templates_t atomicassets::get_templates(name collection_name) {
     return templates_t(get_self(), collection_name.value);
+}
+
+atomicassets::supplies_t atomicassets::get_supplies(name collection_name) {
+    return supplies_t(get_self(), collection_name.value);
+}
+
+
+/**
+* Returns the supply counters of a template
+* For templates that don't have a supplies row yet, the issued_supply is read from the template row
+*/
+atomicassets::supplies_s atomicassets::get_template_supply(name collection_name, const templates_s &template_row) {
+    supplies_t collection_supplies = get_supplies(collection_name);
+    auto supply_itr = collection_supplies.find(template_row.template_id);
+    if (supply_itr != collection_supplies.end()) {
+        return *supply_itr;
+    }
+    return supplies_s{template_row.template_id, template_row.issued_supply, 0, 0, false};
+}
+
+
+atomicassets::dropchunks_t atomicassets::get_airdrop_chunks(uint64_t airdrop_id) {
+    return dropchunks_t(get_self(), airdrop_id);
+}
+
+
+atomicassets::assetoffers_t atomicassets::get_asset_offers(uint64_t asset_id) {
+    return assetoffers_t(get_self(), asset_id);
+}
+
+
+atomicassets::colauths_t atomicassets::get_collection_auths(name collection_name) {
+    return colauths_t(get_self(), collection_name.value);
+}
+
+
+atomicassets::symbalances_t atomicassets::get_symbol_balances(name owner) {
+    return symbalances_t(get_self(), owner.value);
 }
\ No newline at end of file